@@ -1,9 +1,39 @@
 #include "ArduinoWorkflow.h"
 #include <avr/wdt.h>
-//#include <LowPower.h>
+#ifdef __AVR__
+#include <util/atomic.h>
+#endif
 
 namespace AW {
 
+TEventPools::TSmall TEventPools::Small;
+TEventPools::TLarge TEventPools::Large;
+constexpr TTime TDefaultEnvironment::SensorsPeriod;
+
+void* TEvent::operator new(size_t size) {
+    void* ptr = nullptr;
+    if (size <= TEventPools::TSmall::GetBlockSize()) {
+        ptr = TEventPools::Small.Alloc();
+    }
+    if (ptr == nullptr && size <= TEventPools::TLarge::GetBlockSize()) {
+        ptr = TEventPools::Large.Alloc();
+    }
+    if (ptr == nullptr) {
+        ptr = ::operator new(size);
+    }
+    return ptr;
+}
+
+void TEvent::operator delete(void* ptr) {
+    if (TEventPools::Small.Owns(ptr)) {
+        TEventPools::Small.Free(ptr);
+    } else if (TEventPools::Large.Owns(ptr)) {
+        TEventPools::Large.Free(ptr);
+    } else {
+        ::operator delete(ptr);
+    }
+}
+
 void TActorContext::Send(TActor* sender, TActor* recipient, TEventPtr event) const {
     ActorLib.Send(sender, recipient, event);
 }
@@ -20,7 +50,42 @@ void TActorContext::ResendImmediate(TActor* recipient, TEventPtr event) const {
     ActorLib.ResendImmediate(recipient, event);
 }
 
-TActorLib::TActorLib() {
+void TActorContext::Call(TActor* sender, TActor* recipient, TEventPtr event) const {
+    ActorLib.Call(sender, recipient, event, *this);
+}
+
+void TActorContext::Schedule(TTimer& timer, TActor* recipient, TTime notBefore) const {
+    ActorLib.Schedule(timer, recipient, notBefore);
+}
+
+void TActorContext::Reschedule(TTimer& timer, TActor* recipient, TTime notBefore) const {
+    ActorLib.Reschedule(timer, recipient, notBefore);
+}
+
+void TActorContext::Start(TTimer& timer, TActor* recipient, TTime period, TTime first) const {
+    ActorLib.Start(timer, recipient, period, first);
+}
+
+void TActorContext::Start(TTimer& timer, TActor* recipient, TTime period) const {
+    ActorLib.Start(timer, recipient, period);
+}
+
+void TActorContext::Cancel(TTimer& timer) const {
+    ActorLib.Cancel(timer);
+}
+
+TActorLib::TActorLib()
+    : Actors(nullptr)
+    , ReadyBegin(nullptr)
+    , ReadyEnd(nullptr)
+    , Idle(nullptr)
+    , Scheduling(EScheduling::Priority)
+    , Deadlines{ TTime::MilliSeconds(1000), TTime::MilliSeconds(20), TTime::MilliSeconds(1) }
+    , CallDepth(0)
+    , Phases(0)
+    , CallHandler(nullptr)
+    , CallHandlerTarget(nullptr)
+{
     wdt_disable();
 }
 
@@ -34,68 +99,379 @@ void TActorLib::Register(TActor* actor) {
         }
         itActor->NextActor = actor;
     }
-    TEventPtr bootstrapEvent = new TEventBootstrap;
-    Send(actor, actor, bootstrapEvent);
+    Bootstrap(actor);
     wdt_enable(WDTO_8S);
 }
 
+void TActorLib::Bootstrap(TActor* actor) {
+    Send(actor, actor, new TEventBootstrap);
+}
+
+void TActorLib::SetIdle(TIdle* idle) {
+    Idle = idle;
+}
+
+void TActorLib::SetScheduling(EScheduling scheduling) {
+    Scheduling = scheduling;
+}
+
+void TActorLib::SetDeadline(EPriority priority, TTime deadline) {
+    Deadlines[(int)priority] = deadline;
+}
+
 void TActorLib::Run() {
-    TActorContext context(*this);
-    TActor* itActor = Actors;
-    TTime minSleep = TTime::Max();
-    while (itActor != nullptr) {
-        wdt_reset();
-        auto& events(itActor->Events);
-        auto end(events.end());
-        auto itEvent = events.begin();
-        while (itEvent != events.end() && itEvent != end) {
-            TEventPtr event = events.pop_value(itEvent);
-            if (context.Now < event->NotBefore) {
-                TTime sleep = event->NotBefore - context.Now;
-                if (minSleep > sleep) {
-                    minSleep = sleep;
-                }
-                auto itEnd = events.push_back(event);
-                if (end == events.end()) {
-                    end = itEnd;
-                }
+    TVirtualHandler handler;
+    Sweep(handler);
+}
+
+TActor* TActorLib::BeginSweep(const TActorContext& context) {
+    Now = context.Now;
+    TInterruptQueue<AW_INTERRUPT_QUEUE>::TSlot slot;
+    // bounded, so a chattering interrupt can't starve the sweep
+    for (int count = 0; count < AW_INTERRUPT_QUEUE && Interrupts.pop(slot); ++count) {
+        // posted at most one micros() wrap ago, or just after Now was taken
+        int32_t age = (uint32_t)Now.MicroSeconds() - slot.Micros;
+        TTime time = age > 0 ? Now - TTime::MicroSeconds(age) : Now;
+        TEventPtr event = new TEventInterrupt(slot.Value, time);
+        event->Sender = nullptr;
+        event->Priority = EPriority::High;
+        Enqueue(slot.Recipient, event, false, true, false);
+    }
+    while (!Timers.empty() && Timers.top()->NotBefore <= Now) {
+        TEventPtr event = Timers.pop();
+        TActor* recipient = event->Recipient;
+        Push(recipient, event, false, false);
+    }
+    // actors made ready during this sweep are handled on the next one
+    TActor* ready = ReadyBegin;
+    ReadyBegin = ReadyEnd = nullptr;
+    return SortReady(ready);
+}
+
+bool TActorLib::RunsBefore(TActor* actor, TActor* other) {
+    TEvent* event = actor->Events.front().Get();
+    TEvent* otherEvent = other->Events.front().Get();
+    if (event == nullptr || otherEvent == nullptr) {
+        return otherEvent == nullptr && event != nullptr;
+    }
+    if (Scheduling == EScheduling::Deadline) {
+        return event->NotBefore + Deadlines[(int)event->Priority] < otherEvent->NotBefore + Deadlines[(int)otherEvent->Priority];
+    }
+    return event->Priority > otherEvent->Priority;
+}
+
+// insertion sort, stable and cheap for the few actors of a board
+TActor* TActorLib::SortReady(TActor* ready) {
+    TActor* sorted = nullptr;
+    while (ready != nullptr) {
+        TActor* actor = ready;
+        ready = ready->NextReady;
+        TActor** link = &sorted;
+        while (*link != nullptr && !RunsBefore(actor, *link)) {
+            link = &(*link)->NextReady;
+        }
+        actor->NextReady = *link;
+        *link = actor;
+    }
+    return sorted;
+}
+
+TActor* TActorLib::TakeUrgent(TActor* next, uint8_t& count) {
+    TActor* urgentBegin = nullptr;
+    TActor* urgentEnd = nullptr;
+    TActor* last = nullptr;
+    TActor** link = &ReadyBegin;
+    while (*link != nullptr) {
+        TActor* actor = *link;
+        if (RunsBefore(actor, next)) {
+            *link = actor->NextReady;
+            actor->NextReady = nullptr;
+            if (urgentEnd == nullptr) {
+                urgentBegin = actor;
             } else {
-                minSleep = TTime::Zero();
-                itActor->OnEvent(event, context);
-                if (itEvent != events.begin())
-                    break;
+                urgentEnd->NextReady = actor;
             }
+            urgentEnd = actor;
+            ++count;
+        } else {
+            last = actor;
+            link = &actor->NextReady;
+        }
+    }
+    ReadyEnd = last;
+    if (urgentBegin == nullptr) {
+        return next;
+    }
+    TActor* urgent = SortReady(urgentBegin);
+    TActor* itActor = urgent;
+    while (itActor->NextReady != nullptr) {
+        itActor = itActor->NextReady;
+    }
+    itActor->NextReady = next;
+    return urgent;
+}
+
+void TActorLib::EndSweep() {
+    if (ReadyBegin == nullptr && Idle != nullptr) {
+        TTime minSleep = TTime::Max();
+        if (!Timers.empty()) {
+            TTime now = TTime::Now();
+            TTime notBefore = Timers.top()->NotBefore;
+            minSleep = now < notBefore ? notBefore - now : TTime::Zero();
+        }
+        if (minSleep != TTime::Zero()) {
+            Idle->Sleep(minSleep);
         }
-        itActor = itActor->NextActor;
     }
-    //if (true) {
-    //	LowPower.powerStandby(SLEEP_30MS, ADC_ON, BOD_ON);
-    //	wdt_enable(WDTO_8S);
-    //}
+}
+
+void TActorLib::MakeReady(TActor* actor) {
+    if (!actor->Ready) {
+        actor->Ready = true;
+        if (ReadyEnd == nullptr) {
+            ReadyBegin = actor;
+        } else {
+            ReadyEnd->NextReady = actor;
+        }
+        ReadyEnd = actor;
+    }
+}
+
+void TActorLib::Enqueue(TActor* recipient, TEventPtr event, bool immediate, bool bounded, bool resent) {
+    event->Recipient = recipient;
+    if (Now < event->NotBefore) {
+        Timers.push(event);
+        return;
+    }
+    // timers keep the time they were due at
+    event->NotBefore = Now;
+    if (!bounded || Admit(recipient, event)) {
+        Push(recipient, event, immediate, resent);
+    }
+}
+
+void TActorLib::Push(TActor* recipient, TEventPtr event, bool immediate, bool resent) {
+    auto& events(recipient->Events);
+    if (immediate) {
+        events.push_front(event);
+    } else if (resent || events.empty() || !(events.back()->Priority < event->Priority)) {
+        events.push_back(event);
+    } else {
+        auto itEvent = events.begin();
+        while (!(itEvent.Get()->Priority < event->Priority)) {
+            ++itEvent;
+        }
+        events.insert(itEvent, event);
+    }
+    ++recipient->Size;
+    MakeReady(recipient);
+}
+
+// makes room in a full mailbox, false when the event is dropped instead
+bool TActorLib::Admit(TActor* recipient, TEventPtr& event) {
+    if (recipient->Capacity == 0 || recipient->Size < recipient->Capacity) {
+        return true;
+    }
+    ++recipient->Dropped;
+    auto& events(recipient->Events);
+    auto itVictim = events.end();
+    if (recipient->Policy == EOverflow::DropLowest) {
+        // the first of a class is its oldest, a lower class comes later
+        for (auto itEvent = events.begin(); itEvent != events.end(); ++itEvent) {
+            TEvent* queued = itEvent.Get();
+            if (!IsOwn(recipient, queued) && (itVictim == events.end() || queued->Priority < itVictim.Get()->Priority)) {
+                itVictim = itEvent;
+            }
+        }
+    } else if (recipient->Policy == EOverflow::Coalesce) {
+        for (auto itEvent = events.begin(); itEvent != events.end(); ++itEvent) {
+            TEvent* queued = itEvent.Get();
+            if (!IsOwn(recipient, queued) && queued->EventID == event->EventID) {
+                itVictim = itEvent;
+                break;
+            }
+        }
+    }
+    if (itVictim != events.end()) {
+        // the incoming event is then pushed in priority order
+        events.erase(itVictim);
+        --recipient->Size;
+        return true;
+    }
+    event = nullptr;
+    return false;
 }
 
 void TActorLib::Send(TActor* sender, TActor* recipient, TEventPtr event) {
     event->Sender = sender;
-    //event->Recipient = recipient;
-    recipient->Events.push_back(event);
+    Enqueue(recipient, event, false, true, false);
 }
 
 void TActorLib::SendImmediate(TActor* sender, TActor* recipient, TEventPtr event) {
     event->Sender = sender;
-    //event->Recipient = recipient;
-    recipient->Events.push_front(event);
+    Enqueue(recipient, event, true, true, false);
+}
+
+void TActorLib::Call(TActor* sender, TActor* recipient, TEventPtr event, const TActorContext& context) {
+    event->Sender = sender;
+    if (CallHandler != nullptr && CallDepth < AW_CALL_DEPTH && !recipient->Running && recipient->Size == 0 && !(Now < event->NotBefore)) {
+        event->Recipient = recipient;
+        ++CallDepth;
+        recipient->Running = true;
+        CallHandler(CallHandlerTarget, recipient, event, context);
+        recipient->Running = false;
+        --CallDepth;
+    } else {
+        Enqueue(recipient, event, false, true, false);
+    }
 }
 
 void TActorLib::Resend(TActor* recipient, TEventPtr event) {
-    recipient->Events.push_back(event);
+    Enqueue(recipient, event, false, false, true);
 }
 
 void TActorLib::ResendImmediate(TActor* recipient, TEventPtr event) {
-    recipient->Events.push_front(event);
+    Enqueue(recipient, event, true, false, true);
+}
+
+TEventPtr TActorLib::Take(TEvent* event) {
+    int index = Timers.find(event);
+    if (index >= 0) {
+        return Timers.erase(index);
+    }
+    TActor* recipient = event->Recipient;
+    auto& events(recipient->Events);
+    for (auto itEvent = events.begin(); itEvent != events.end(); ++itEvent) {
+        if (itEvent.Get() == event) {
+            --recipient->Size;
+            return events.pop_value(itEvent);
+        }
+    }
+    return nullptr;
+}
+
+void TActorLib::Schedule(TTimer& timer, TActor* recipient, TTime notBefore) {
+    if (!timer.Pending()) {
+        Reschedule(timer, recipient, notBefore);
+    }
+}
+
+void TActorLib::Reschedule(TTimer& timer, TActor* recipient, TTime notBefore) {
+    TEventPtr event;
+    if (timer.Pending()) {
+        event = Take(timer.Event);
+    }
+    if (event.Get() == nullptr) {
+        event = new TEventReceive();
+        event->Timer = &timer;
+        timer.Event = event.Get();
+    }
+    event->Sender = recipient;
+    event->NotBefore = notBefore;
+    Enqueue(recipient, event, false, false, false);
+}
+
+void TActorLib::Start(TTimer& timer, TActor* recipient, TTime period, TTime first) {
+    timer.Period = period;
+    timer.Missed = 0;
+    Reschedule(timer, recipient, first);
+}
+
+void TActorLib::Start(TTimer& timer, TActor* recipient, TTime period) {
+    // bit-reversed count: 0, 1/2, 1/4, 3/4, 1/8... of the period, so any
+    // number of timers sharing a period stay evenly spread
+    uint8_t phase = Phases++;
+    phase = (phase & 0xf0) >> 4 | (phase & 0x0f) << 4;
+    phase = (phase & 0xcc) >> 2 | (phase & 0x33) << 2;
+    phase = (phase & 0xaa) >> 1 | (phase & 0x55) << 1;
+    TTime offset = TTime::MicroSeconds(period.MicroSeconds() / 256 * phase);
+    Start(timer, recipient, period, Now + period + offset);
+}
+
+void TActorLib::Cancel(TTimer& timer) {
+    timer.Period = TTime::Zero();
+    if (timer.Pending()) {
+        Take(timer.Event);
+    }
+}
+
+TEventPtr TActorLib::Pop(TActor* actor) {
+    auto itEvent = actor->Events.begin();
+    TEventPtr event = actor->Events.pop_value(itEvent);
+    --actor->Size;
+    TTimer* timer = event->Timer;
+    if (timer != nullptr && !timer->Periodic()) {
+        // fired, the handler may schedule it again
+        timer->Event = nullptr;
+        event->Timer = nullptr;
+    }
+    return event;
+}
+
+bool TActorLib::IsTick(const TEvent* event) {
+    return event->Timer != nullptr && event->Timer->Periodic();
+}
+
+bool TActorLib::IsOwn(const TActor* actor, const TEvent* event) {
+    return event->Timer != nullptr || event->Sender == actor;
+}
+
+void TActorLib::Rearm(TEventPtr event, const TActorContext& context) {
+    TTimer* timer = event->Timer;
+    uint64_t period = timer->Period.MicroSeconds();
+    TTime next = event->NotBefore + timer->Period;
+    timer->Missed = 0;
+    if (!(context.Now < next)) {
+        // whole periods slept through are skipped, the phase is kept
+        uint64_t missed = (context.Now - next).MicroSeconds() / period + 1;
+        next = next + TTime::MicroSeconds(missed * period);
+        timer->Missed = missed < 0xffff ? missed : 0xffff;
+    }
+    event->NotBefore = next;
+    Timers.push(event);
+}
+
+volatile bool TIdle::Woken = false;
+
+bool TActorLib::SendFromInterrupt(TActor* recipient, uint16_t value) {
+    bool result = Interrupts.push(recipient, value, micros());
+    TIdle::Wake();
+    return result;
+}
+
+uint8_t TActorLib::GetInterruptsDropped() const {
+    return Interrupts.dropped();
+}
+
+int TActorLib::GetDeferred(TActor* actor) const {
+    int count = 0;
+    for (int i = 0; i < Timers.size(); ++i) {
+        if (Timers[i]->Recipient == actor) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+TTime TTime::Now() {
+    static uint32_t last = 0;
+    static uint32_t wraps = 0;
+#ifdef __AVR__
+    // interrupts may ask for the time too
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+    {
+        uint32_t now = micros();
+        if (now < last) {
+            ++wraps;
+        }
+        last = now;
+        return TTime(((uint64_t)wraps << 32) | now);
+    }
 }
 
 String TTime::AsString() const {
-    return String(Value);
+    return String(MilliSeconds());
 }
 
 }
\ No newline at end of file
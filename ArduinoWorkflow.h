@@ -2,8 +2,50 @@
 
 #include <Arduino.h>
 #include <avr/eeprom.h>
+#include <avr/wdt.h>
 #include <Wire.h>
 
+// number of preallocated event blocks, 0 sends events straight to the heap.
+// every block takes static RAM whether used or not, on AVR about 27 bytes
+// small and 41 large (sizeof(TEvent) + 4, + 18 with String events), so 12
+// and 4 take some 500 bytes, a quarter of an ATmega328
+#ifndef AW_EVENT_POOL_SMALL
+#define AW_EVENT_POOL_SMALL 0
+#endif
+
+#ifndef AW_EVENT_POOL_LARGE
+#define AW_EVENT_POOL_LARGE 0
+#endif
+
+// number of events interrupts can post between two runs
+#ifndef AW_INTERRUPT_QUEUE
+#define AW_INTERRUPT_QUEUE 8
+#endif
+
+// how deep TActorContext::Call may nest handlers on the stack
+#ifndef AW_CALL_DEPTH
+#define AW_CALL_DEPTH 4
+#endif
+
+// events an actor handles per sweep unless it sets its own budget
+#ifndef AW_EVENT_BUDGET
+#define AW_EVENT_BUDGET 8
+#endif
+
+// characters an AW::String keeps inside the object before going to the heap
+#ifndef AW_STRING_INLINE
+#define AW_STRING_INLINE 12
+#endif
+
+// characters of text the serial and sensor message events keep inside the
+// event, 0 carries a String instead. TSerialActor drops received lines longer
+// than this and counts them in GetLongLines(), the sensor texts need 32
+#ifndef AW_EVENT_STRING
+#define AW_EVENT_STRING 0
+#endif
+
+#include "StringBuf.h"
+
 namespace AW {
 
 class ArduinoSettings {
@@ -414,6 +456,7 @@ public:
         friend TList;
     private:
         TUniquePtr<ItemType> Next;
+        ItemType* Prev = nullptr;
     };
     
     class Iterator {
@@ -450,6 +493,10 @@ public:
         ItemType* Item;
     };
 
+    TList()
+        : End(nullptr)
+    {}
+
     int size() {
         int s = 0;
         Iterator it = begin();
@@ -476,6 +523,10 @@ public:
         return Begin;
     }
 
+    ItemType* back() {
+        return End;
+    }
+
     Iterator push_back(TItemType item) {
         return insert(end(), item);
     }
@@ -489,99 +540,345 @@ public:
     }
 
     TItemType pop_value(Iterator& it) {
-        if (it == begin()) {
-            TItemType value(Begin);
-            it = (Begin = value->Next).Get();
-            return value;
+        ItemType* item = it.Get();
+        ItemType* prev = item->Prev;
+        ItemType* next = item->Next.Get();
+        TItemType value;
+        if (prev == nullptr) {
+            value = Begin;
+            Begin = value->Next;
         } else {
-            Iterator next = begin();
-            while (next != end()) {
-                Iterator prev = next++;
-                if (next == it) {
-                    TItemType value(prev.Get()->Next);
-                    it = (prev.Get()->Next = value->Next).Get();
-                    return value;
-                }
-            }
+            value = prev->Next;
+            prev->Next = value->Next;
         }
-        return TItemType();
+        if (next == nullptr) {
+            End = prev;
+        } else {
+            next->Prev = prev;
+        }
+        value->Prev = nullptr;
+        it = next;
+        return value;
     }
 
     Iterator erase(Iterator it) {
-        if (it == begin()) {
-            Begin = Begin->Next;
-            return Begin.Get();
-        } else {
-            Iterator next = begin();
-            while (next != end()) {
-                Iterator prev = next++;
-                if (next == it) {
-                    return (prev.Get()->Next = next.Get()->Next).Get();
-                }
-            }
-        }
-        return end();
+        pop_value(it);
+        return it;
     }
 
     Iterator insert(Iterator it, TItemType item) {
-        if (it == begin()) {
+        ItemType* next = it.Get();
+        ItemType* prev = next == nullptr ? End : next->Prev;
+        ItemType* value = item.Get();
+        value->Prev = prev;
+        if (prev == nullptr) {
             item->Next = Begin;
             Begin = item;
-            return begin();
         } else {
-            Iterator next = begin();
-            while (next != end()) {
-                Iterator prev = next++;
-                if (next == it) {
-                    item->Next = prev.Get()->Next;
-                    prev.Get()->Next = item;
-                    return next;
-                }
-            }
+            item->Next = prev->Next;
+            prev->Next = item;
+        }
+        if (next == nullptr) {
+            End = value;
+        } else {
+            next->Prev = value;
         }
-        return end();
+        return value;
     }
 
 protected:
     TUniquePtr<ItemType> Begin;
+    ItemType* End;
+};
+
+// binary min-heap on NotBefore, keeps delayed events away from the mailboxes.
+// equal deadlines are broken by push order, so they still come out FIFO
+template <typename ItemType>
+class TTimerHeap {};
+
+template <typename ItemType>
+class TTimerHeap<TUniquePtr<ItemType>> {
+public:
+    using TItemType = TUniquePtr<ItemType>;
+
+    TTimerHeap()
+        : Data(nullptr)
+        , Size(0)
+        , Capacity(0)
+        , Sequence(0)
+    {}
+
+    ~TTimerHeap() {
+        while (!empty()) {
+            pop();
+        }
+        free(Data);
+    }
+
+    int size() const {
+        return Size;
+    }
+
+    bool empty() const {
+        return Size == 0;
+    }
+
+    ItemType* top() const {
+        return Data[0].Item;
+    }
+
+    // heap order, not time order
+    ItemType* operator [](int index) const {
+        return Data[index].Item;
+    }
+
+    void push(TItemType item) {
+        if (Size == Capacity) {
+            int capacity = Capacity == 0 ? 4 : Capacity * 2;
+            TEntry* data = (TEntry*)realloc(Data, capacity * sizeof(TEntry));
+            if (data == nullptr) {
+                Serial.print("\nOVERFLOW!\n");
+                return;
+            }
+            Data = data;
+            Capacity = capacity;
+        }
+        Data[Size].Item = item.Release();
+        Data[Size].Sequence = Sequence++;
+        SiftUp(Size++);
+    }
+
+    TItemType pop() {
+        return erase(0);
+    }
+
+    TItemType erase(int index) {
+        TItemType value(Data[index].Item);
+        if (index != --Size) {
+            Data[index] = Data[Size];
+            SiftDown(index);
+            SiftUp(index);
+        }
+        return value;
+    }
+
+    int find(const ItemType* item) const {
+        for (int i = 0; i < Size; ++i) {
+            if (Data[i].Item == item) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+protected:
+    struct TEntry {
+        ItemType* Item;
+        uint16_t Sequence;
+    };
+
+    TEntry* Data;
+    int Size;
+    int Capacity;
+    uint16_t Sequence;
+
+    // sequence compared modulo 2^16, fine while fewer than 32768 pushes
+    // separate two timers with the same deadline
+    static bool Less(const TEntry& a, const TEntry& b) {
+        if (a.Item->NotBefore != b.Item->NotBefore) {
+            return a.Item->NotBefore < b.Item->NotBefore;
+        }
+        return (int16_t)(uint16_t)(a.Sequence - b.Sequence) < 0;
+    }
+
+    void SiftUp(int idx) {
+        TEntry value = Data[idx];
+        while (idx > 0) {
+            int parent = (idx - 1) / 2;
+            if (!Less(value, Data[parent])) {
+                break;
+            }
+            Data[idx] = Data[parent];
+            idx = parent;
+        }
+        Data[idx] = value;
+    }
+
+    void SiftDown(int idx) {
+        TEntry value = Data[idx];
+        for (;;) {
+            int child = idx * 2 + 1;
+            if (child >= Size) {
+                break;
+            }
+            if (child + 1 < Size && Less(Data[child + 1], Data[child])) {
+                ++child;
+            }
+            if (!Less(Data[child], value)) {
+                break;
+            }
+            Data[idx] = Data[child];
+            idx = child;
+        }
+        Data[idx] = value;
+    }
+};
+
+// fixed-size block allocator, falls back to the caller when exhausted
+template <size_t BlockSize, int BlockCount>
+class TPool {
+public:
+    constexpr TPool()
+        : Blocks()
+        , FreeBlock(nullptr)
+        , Fresh(0)
+        , Used(0)
+        , MaxUsed(0)
+        , Overflows(0)
+    {}
+
+    void* Alloc() {
+        TBlock* block = FreeBlock;
+        if (block != nullptr) {
+            FreeBlock = block->Next;
+        } else if (Fresh < BlockCount) {
+            block = &Blocks[Fresh++];
+        } else {
+            ++Overflows;
+            return nullptr;
+        }
+        if (++Used > MaxUsed) {
+            MaxUsed = Used;
+        }
+        return block;
+    }
+
+    bool Owns(const void* ptr) const {
+        return ptr >= &Blocks[0] && ptr < &Blocks[BlockCount];
+    }
+
+    void Free(void* ptr) {
+        TBlock* block = static_cast<TBlock*>(ptr);
+        block->Next = FreeBlock;
+        FreeBlock = block;
+        --Used;
+    }
+
+    static constexpr size_t GetBlockSize() { return BlockSize; }
+    static constexpr int GetBlockCount() { return BlockCount; }
+    int GetUsed() const { return Used; }
+    int GetMaxUsed() const { return MaxUsed; }
+    int GetOverflows() const { return Overflows; }
+
+protected:
+    union TBlock {
+        TBlock* Next;
+        unsigned long long Align;
+        char Data[BlockSize];
+    };
+
+    TBlock Blocks[BlockCount];
+    TBlock* FreeBlock;
+    int Fresh;
+    int Used;
+    int MaxUsed;
+    int Overflows;
+};
+
+template <size_t BlockSize>
+class TPool<BlockSize, 0> {
+public:
+    void* Alloc() { return nullptr; }
+    bool Owns(const void*) const { return false; }
+    void Free(void*) {}
+
+    static constexpr size_t GetBlockSize() { return BlockSize; }
+    static constexpr int GetBlockCount() { return 0; }
+    int GetUsed() const { return 0; }
+    int GetMaxUsed() const { return 0; }
+    int GetOverflows() const { return 0; }
 };
 
 using TEventID = unsigned int;
-class String;
 
+// one place for all event IDs of the library, so they never collide
+enum EEventID : TEventID {
+    EventBootstrap,
+    EventReceive,
+    EventSerialData,
+    EventLedOn,
+    EventLedOff,
+    EventLedBlink,
+    EventSensorData,
+    EventSensorMessage,
+    EventInterrupt,
+    EventUser, // first ID available for events defined in sketches
+};
+
+// microseconds since reset, 64 bits never wrap so plain comparisons are safe
 class TTime {
 public:
     constexpr TTime()
         : Value() {}
 
     bool operator ==(TTime time) const { return Value == time.Value; }
+    bool operator !=(TTime time) const { return Value != time.Value; }
     bool operator <(TTime time) const { return Value < time.Value; }
     bool operator <=(TTime time) const { return Value <= time.Value; }
     bool operator >(TTime time) const { return Value > time.Value; }
     bool operator >=(TTime time) const { return Value >= time.Value; }
     TTime operator +(TTime time) const { return TTime(Value + time.Value); }
     TTime operator -(TTime time) const { return TTime(Value - time.Value); }
-    static constexpr TTime MilliSeconds(unsigned long ms) { return TTime(ms); }
-    static constexpr TTime Seconds(unsigned long s) { return TTime(s * 1000); }
-    static TTime Now() { return TTime(millis()); }
+    static constexpr TTime MicroSeconds(uint64_t us) { return TTime(us); }
+    static constexpr TTime MilliSeconds(unsigned long ms) { return TTime(ms * 1000ull); }
+    static constexpr TTime Seconds(unsigned long s) { return TTime(s * 1000000ull); }
+    // micros() extended with a count of its wraps, has to be called at least
+    // once every 71 minutes (Run and the idle loop do)
+    static TTime Now();
     String AsString() const;
-    constexpr unsigned long MilliSeconds() const { return Value; }
-    static constexpr TTime Max() { return TTime(-1); }
+    constexpr uint64_t MicroSeconds() const { return Value; }
+    constexpr unsigned long MilliSeconds() const { return Value / 1000; }
+    static constexpr TTime Max() { return TTime(~0ull); }
     static constexpr TTime Zero() { return TTime(0); }
 
 protected:
-    constexpr TTime(unsigned long ms)
-        : Value(ms) {}
+    constexpr TTime(uint64_t us)
+        : Value(us) {}
 
-    unsigned long Value;
+    uint64_t Value;
 };
 
 class TActor;
 struct TEvent;
 class TActorLib;
 
+// handle to at most one pending TEventReceive, see TActorContext::Schedule
+// it is free again once the event reaches the handler or is cancelled, and
+// should live as long as its actor
+// started with TActorContext::Start it is periodic instead: the same event
+// stays armed and the recipient's OnTimer is called on every tick
+class TTimer {
+    friend class TActorLib;
+    friend struct TEvent;
+    TEvent* Event = nullptr;
+    TTime Period;
+    uint16_t Missed = 0;
+public:
+    TTimer() = default;
+    TTimer(const TTimer&) = delete;
+    TTimer& operator =(const TTimer&) = delete;
+
+    bool Pending() const { return Event != nullptr; }
+    bool Periodic() const { return Period != TTime::Zero(); }
+    TTime GetPeriod() const { return Period; }
+    // ticks skipped right before the current one because the loop was late
+    uint16_t GetMissed() const { return Missed; }
+};
+
 using TActorPtr = TActor*;
 using TEventPtr = TUniquePtr<TEvent>;
+// events handed over together to TActor::OnEventBatch, oldest first
+using TEventBatch = TList<TEventPtr>;
 
 struct TActorContext {
     TActorLib& ActorLib;
@@ -596,23 +893,143 @@ struct TActorContext {
     void SendImmediate(TActor* sender, TActor* recipient, TEventPtr event) const;
     void Resend(TActor* recipient, TEventPtr event) const;
     void ResendImmediate(TActor* recipient, TEventPtr event) const;
+    // like Send, but runs the recipient's handler right away when it is idle
+    void Call(TActor* sender, TActor* recipient, TEventPtr event) const;
+    // keeps the pending time when the timer is already pending
+    void Schedule(TTimer& timer, TActor* recipient, TTime notBefore) const;
+    // moves the pending event, or schedules a new one
+    void Reschedule(TTimer& timer, TActor* recipient, TTime notBefore) const;
+    // ticks every period from first on, next = previous + period, however late
+    // the handlers run
+    void Start(TTimer& timer, TActor* recipient, TTime period, TTime first) const;
+    // the first tick comes a period and a phase offset from now, offsets of
+    // successive timers spread over the period so they don't fire together
+    void Start(TTimer& timer, TActor* recipient, TTime period) const;
+    // stops a periodic timer as well
+    void Cancel(TTimer& timer) const;
+};
+
+// what a full mailbox does with one more event. the actor's own timer and
+// resent events are never the ones deleted
+enum class EOverflow : uint8_t {
+    DropNewest, // the incoming event is deleted
+    // the oldest event of the lowest priority queued is deleted, with a single
+    // priority class that is the oldest one. the mailbox is kept in priority
+    // order, not arrival order, so urgent events are the last to go
+    DropLowest,
+    // the incoming event replaces the queued one with the same EventID that
+    // would be handled first, or is deleted
+    Coalesce,
 };
 
 class TActor {
 private:
     friend class TActorLib;
     TActor* NextActor = nullptr;
-    //TDeque<TEventPtr, 9> Events;
+    TActor* NextReady = nullptr;
+    bool Ready = false;
+    bool Running = false;
+    uint8_t Capacity = 0; // 0 is unbounded
+    EOverflow Policy = EOverflow::DropNewest;
+    bool Batched = false;
+    uint8_t Budget = AW_EVENT_BUDGET;
+    uint16_t BudgetMicros = 0; // 0 is no time limit
+    uint16_t Size = 0;
+    uint16_t Dropped = 0;
     TList<TEventPtr> Events;
 public:
+    TActor() = default;
+
+    TActor(uint8_t capacity, EOverflow policy)
+        : Capacity(capacity)
+        , Policy(policy)
+    {}
+
+    // events lost to a full mailbox
+    uint16_t GetDropped() const { return Dropped; }
+    // the mailbox limit, 0 is unbounded
+    uint8_t GetCapacity() const { return Capacity; }
+
+    // how many of its queued events the actor handles in one sweep before the
+    // others get their turn, optionally cut short after micros, one at least
+    void SetBudget(uint8_t events, uint16_t micros = 0) {
+        Budget = events != 0 ? events : 1;
+        BudgetMicros = micros;
+    }
+
+    // takes OnEventBatch instead of OnEvent, for actors that do better with
+    // all their due events at once
+    void SetBatched(bool batched) {
+        Batched = batched;
+    }
+
     virtual void OnEvent(TEventPtr event, const TActorContext& context) = 0;
+    // a tick of a periodic timer started for this actor
+    virtual void OnTimer(TTimer& /*timer*/, const TActorContext& /*context*/) {}
+    // up to the budget of events at once, periodic ticks still go to OnTimer,
+    // events left in the batch are deleted
+    virtual void OnEventBatch(TEventBatch& batch, const TActorContext& context) {
+        while (!batch.empty()) {
+            auto itEvent = batch.begin();
+            OnEvent(batch.pop_value(itEvent), context);
+        }
+    }
+};
+
+// mailbox limit of an actor, passed to TActorHandlers right after the actor type
+// only events sent by others count, Resend and timers always get through so
+// an actor never loses its own periodic event
+template <uint8_t Capacity, EOverflow Policy = EOverflow::DropNewest>
+struct TMailbox {};
+
+// urgency of an event, higher classes are queued ahead of lower ones in the
+// mailbox, and their actors ahead of others in the sweep
+enum class EPriority : uint8_t {
+    Low, // bulk work like formatting telemetry
+    Normal,
+    High, // draining hardware buffers, reading a sensor within its window
+};
+
+// how TActorLib orders the actors ready in a sweep, ties keep the order they
+// became ready in
+enum class EScheduling : uint8_t {
+    Priority, // by the priority of the first event in the mailbox
+    Deadline, // by the deadline of that event: due time plus its class' deadline
 };
 
 struct TEvent : TList<TUniquePtr<TEvent>>::TItemBase {
-    TTime NotBefore;
+    TTime NotBefore; // becomes the due time once the event is queued
     TActor* Sender;
-    //TActor* Recipient;
+    TActor* Recipient;
     TEventID EventID;
+    EPriority Priority = EPriority::Normal;
+    TTimer* Timer = nullptr;
+
+    // events are deleted through TEventPtr, their members have to go too
+    virtual ~TEvent() {
+        if (Timer != nullptr) {
+            Timer->Event = nullptr;
+        }
+    }
+
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
+};
+
+#if AW_EVENT_STRING
+using TEventString = TStaticString<AW_EVENT_STRING>;
+#else
+using TEventString = String;
+#endif
+
+// small blocks fit bare events and events with a couple of references,
+// large blocks fit events carrying a TEventString
+struct TEventPools {
+    using TSmall = TPool<sizeof(TEvent) + 2 * sizeof(void*), AW_EVENT_POOL_SMALL>;
+    using TLarge = TPool<sizeof(TEvent) + sizeof(void*) + sizeof(TEventString), AW_EVENT_POOL_LARGE>;
+
+    static TSmall Small;
+    static TLarge Large;
 };
 
 template <typename DerivedType>
@@ -623,11 +1040,11 @@ struct TBasicEvent : TEvent {
 };
 
 struct TEventBootstrap : TBasicEvent<TEventBootstrap> {
-    constexpr static TEventID EventID = 0; // TODO
+    constexpr static TEventID EventID = EventBootstrap;
 };
 
 struct TEventReceive : TBasicEvent<TEventReceive> {
-    constexpr static TEventID EventID = 1; // TODO
+    constexpr static TEventID EventID = EventReceive;
 
     TEventReceive() = default;
 
@@ -636,25 +1053,390 @@ struct TEventReceive : TBasicEvent<TEventReceive> {
     }
 };
 
+// posted with TActorLib::SendFromInterrupt
+struct TEventInterrupt : TBasicEvent<TEventInterrupt> {
+    constexpr static TEventID EventID = EventInterrupt;
+    uint16_t Value;
+    TTime Time;
+
+    TEventInterrupt(uint16_t value, TTime time)
+        : Value(value)
+        , Time(time) {}
+};
+
+// lock-free ring between interrupts (producer) and the main loop (consumer),
+// no allocations and no disabled interrupts on either side
+template <int Capacity>
+class TInterruptQueue {
+    static_assert(Capacity < 255, "capacity should fit uint8_t indexes");
+
+public:
+    struct TSlot {
+        TActor* Recipient;
+        uint16_t Value;
+        uint32_t Micros;
+    };
+
+    TInterruptQueue()
+        : Head(0)
+        , Tail(0)
+        , Dropped(0)
+    {}
+
+    bool push(TActor* recipient, uint16_t value, uint32_t micros) {
+        uint8_t head = __atomic_load_n(&Head, __ATOMIC_RELAXED);
+        uint8_t next = head == Capacity ? 0 : head + 1;
+        if (next == __atomic_load_n(&Tail, __ATOMIC_ACQUIRE)) {
+            __atomic_store_n(&Dropped, Dropped + 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        Slots[head].Recipient = recipient;
+        Slots[head].Value = value;
+        Slots[head].Micros = micros;
+        __atomic_store_n(&Head, next, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool pop(TSlot& slot) {
+        uint8_t tail = __atomic_load_n(&Tail, __ATOMIC_RELAXED);
+        if (tail == __atomic_load_n(&Head, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        slot = Slots[tail];
+        __atomic_store_n(&Tail, tail == Capacity ? 0 : tail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    uint8_t dropped() const {
+        return __atomic_load_n(&Dropped, __ATOMIC_RELAXED);
+    }
+
+protected:
+    TSlot Slots[Capacity + 1];
+    uint8_t Head;
+    uint8_t Tail;
+    uint8_t Dropped;
+};
+
+template <TEventID ID, typename... EventTypes>
+struct TEventIDUnused {
+    static constexpr bool Value = true;
+};
+
+template <TEventID ID, typename EventType, typename... EventTypes>
+struct TEventIDUnused<ID, EventType, EventTypes...> {
+    static constexpr bool Value = ID != EventType::EventID && TEventIDUnused<ID, EventTypes...>::Value;
+};
+
+template <typename... EventTypes>
+struct TEventIDsUnique {
+    static constexpr bool Value = true;
+};
+
+template <typename EventType, typename... EventTypes>
+struct TEventIDsUnique<EventType, EventTypes...> {
+    static constexpr bool Value = TEventIDUnused<EventType::EventID, EventTypes...>::Value && TEventIDsUnique<EventTypes...>::Value;
+};
+
+// actors with protected handlers declare it as a friend
+struct TEventHandlerAccess {
+    template <typename ActorType, typename EventType>
+    static void Invoke(TActor* actor, TEventPtr& event, const TActorContext& context) {
+        static_cast<ActorType*>(actor)->Handle(static_cast<EventType*>(event.Release()), context);
+    }
+
+    // the actor's own overrides called without the virtual dispatch, used by
+    // TArduinoWorkflow which knows the actor's type
+    template <typename ActorType>
+    static void Dispatch(ActorType& actor, TEventPtr& event, const TActorContext& context) {
+        actor.ActorType::OnEvent(event, context);
+    }
+
+    template <typename ActorType>
+    static void Timer(ActorType& actor, TTimer& timer, const TActorContext& context) {
+        actor.ActorType::OnTimer(timer, context);
+    }
+
+    template <typename ActorType>
+    static void Batch(ActorType& actor, TEventBatch& batch, const TActorContext& context) {
+        actor.ActorType::OnEventBatch(batch, context);
+    }
+};
+
+// a compare per handled event, unrolled at compile time. the handlers stay
+// visible to the compiler, so they can be inlined, and dense EventIDs become
+// a jump table. no table of function pointers, which on AVR would sit in RAM
+template <typename ActorType, typename... EventTypes>
+struct TEventSwitch {
+    static void Dispatch(TActor*, TEventID, TEventPtr&, const TActorContext&) {}
+};
+
+template <typename ActorType, typename EventType, typename... EventTypes>
+struct TEventSwitch<ActorType, EventType, EventTypes...> {
+    static void Dispatch(TActor* actor, TEventID id, TEventPtr& event, const TActorContext& context) {
+        if (id == EventType::EventID) {
+            TEventHandlerAccess::Invoke<ActorType, EventType>(actor, event, context);
+        } else {
+            TEventSwitch<ActorType, EventTypes...>::Dispatch(actor, id, event, context);
+        }
+    }
+};
+
+// base for actors handling a fixed set of events: ActorType implements
+// Handle(TUniquePtr<EventType>, const TActorContext&) for every EventType
+// and OnEvent becomes a switch on EventID
+template <typename ActorType, typename... EventTypes>
+class TActorHandlers : public TActorHandlers<ActorType, TMailbox<0>, EventTypes...> {};
+
+template <typename ActorType, uint8_t MailboxCapacity, EOverflow MailboxPolicy, typename... EventTypes>
+class TActorHandlers<ActorType, TMailbox<MailboxCapacity, MailboxPolicy>, EventTypes...> : public TActor {
+    static_assert(TEventIDsUnique<EventTypes...>::Value, "two handled events share the same EventID");
+
+protected:
+    TActorHandlers()
+        : TActor(MailboxCapacity, MailboxPolicy)
+    {}
+
+    void OnEvent(TEventPtr event, const TActorContext& context) override {
+        TEventSwitch<ActorType, EventTypes...>::Dispatch(this, event->EventID, event, context);
+    }
+};
+
+// sleep backend used by TActorLib::Run when nothing is due
+class TIdle {
+public:
+    virtual ~TIdle() = default;
+    // sleep at most for the duration, waking up earlier is allowed
+    virtual void Sleep(TTime duration) = 0;
+
+    // call from ISRs which produce work for the actors, SendFromInterrupt
+    // does. a sleep seeing it ends early and clears it
+    static void Wake() { Woken = true; }
+
+protected:
+    static volatile bool Woken;
+};
+
+// TIdleAVR, the sleep of classic ATmega boards, is in IdleAVR.h
+
 class TActorLib {
 public:
     TActorLib();
     void Register(TActor* actor);
+    // sends the actor its TEventBootstrap, Register does it for listed actors
+    void Bootstrap(TActor* actor);
+    void SetIdle(TIdle* idle);
+    void SetScheduling(EScheduling scheduling);
+    // how long after it is due an event of the class should be handled, used
+    // by EScheduling::Deadline
+    void SetDeadline(EPriority priority, TTime deadline);
     void Run();
+    // the same as Run, reporting every dispatch to the monitor (see TSensorActors)
+    template <typename MonitorType>
+    void Run(MonitorType& monitor);
     void Send(TActor* sender, TActor* recipient, TEventPtr event);
     void SendImmediate(TActor* sender, TActor* recipient, TEventPtr event);
     void Resend(TActor* recipient, TEventPtr event);
     void ResendImmediate(TActor* recipient, TEventPtr event);
+    // delivers in place when the recipient has an empty mailbox and is not
+    // on the stack already, falls back to Send otherwise. it goes through
+    // the dispatch of the running sweep, so batching and monitoring apply,
+    // but it bypasses scheduling: the recipient runs now, whatever its
+    // priority, and the event doesn't count against its budget. outside a
+    // sweep it is a Send
+    void Call(TActor* sender, TActor* recipient, TEventPtr event, const TActorContext& context);
+    // the only call safe to use inside an ISR, delivers TEventInterrupt on the next Run
+    bool SendFromInterrupt(TActor* recipient, uint16_t value = 0);
+    uint8_t GetInterruptsDropped() const;
+    void Schedule(TTimer& timer, TActor* recipient, TTime notBefore);
+    void Reschedule(TTimer& timer, TActor* recipient, TTime notBefore);
+    void Start(TTimer& timer, TActor* recipient, TTime period, TTime first);
+    void Start(TTimer& timer, TActor* recipient, TTime period);
+    void Cancel(TTimer& timer);
+    // events of the actor waiting for their NotBefore
+    int GetDeferred(TActor* actor) const;
 
 protected:
-    //TDeque<TEventPtr, 16> Events;
-    
     TActor* Actors;
-    // TDeque<TEventPtr> with different sizes in every actor
-    // or maybe dynamic TDeque<TEventPtr> ?
-    // mailbox should be inside every actor for faster sending
+    TActor* ReadyBegin;
+    TActor* ReadyEnd;
+    TTimerHeap<TEventPtr> Timers;
+    TTime Now;
+    TIdle* Idle;
+    EScheduling Scheduling;
+    TTime Deadlines[3];
+    TInterruptQueue<AW_INTERRUPT_QUEUE> Interrupts;
+    uint8_t CallDepth;
+    uint8_t Phases;
+    // the handler of the running sweep, which Call delivers through
+    void (*CallHandler)(void* handler, TActor* actor, TEventPtr& event, const TActorContext& context);
+    void* CallHandlerTarget;
+
+    // bounded events respect the recipient's mailbox limit
+    void Enqueue(TActor* recipient, TEventPtr event, bool immediate, bool bounded, bool resent);
+    // queues a due event behind those of the same or a higher priority. a
+    // resent event has had its turn and goes behind all of them, so a high
+    // priority poll cannot starve the rest of its own mailbox
+    void Push(TActor* recipient, TEventPtr event, bool immediate, bool resent);
+    bool Admit(TActor* recipient, TEventPtr& event);
+    // takes a pending event back from the timers or from its recipient's mailbox
+    TEventPtr Take(TEvent* event);
+    // puts a periodic timer's event back for its next tick
+    void Rearm(TEventPtr event, const TActorContext& context);
+    // the next event of the actor's mailbox, a one-shot timer is released
+    TEventPtr Pop(TActor* actor);
+    static bool IsTick(const TEvent* event);
+    // timers and resends, never evicted by a full mailbox
+    static bool IsOwn(const TActor* actor, const TEvent* event);
+    void MakeReady(TActor* actor);
+    // true when actor should run before other
+    bool RunsBefore(TActor* actor, TActor* other);
+    TActor* SortReady(TActor* ready);
+    // moves actors made ready during the sweep that should run before next
+    // in front of it, count is how many were moved
+    TActor* TakeUrgent(TActor* next, uint8_t& count);
+    TActor* BeginSweep(const TActorContext& context);
+    void EndSweep();
+
+    struct TVirtualHandler {
+        void operator ()(TActor* actor, TEventPtr& event, const TActorContext& context) {
+            actor->OnEvent(event, context);
+        }
+
+        void operator ()(TActor* actor, TTimer& timer, const TActorContext& context) {
+            actor->OnTimer(timer, context);
+        }
+
+        void operator ()(TActor* actor, TEventBatch& batch, const TActorContext& context) {
+            actor->OnEventBatch(batch, context);
+        }
+    };
+
+    template <typename HandlerType>
+    static void OnCall(void* handler, TActor* actor, TEventPtr& event, const TActorContext& context) {
+        HandlerType& callHandler(*static_cast<HandlerType*>(handler));
+        if (actor->Batched) {
+            TEventBatch batch;
+            batch.push_back(event);
+            callHandler(actor, batch, context);
+        } else {
+            callHandler(actor, event, context);
+        }
+    }
+
+    // handlers reached through Call are reported too, their time also
+    // counts for the caller
+    template <typename HandlerType, typename MonitorType>
+    void MonitoredSweep(HandlerType& handler, MonitorType& monitor) {
+        TMonitoredHandler<HandlerType, MonitorType> monitored = { handler, monitor };
+        Sweep(monitored);
+    }
+
+    template <typename HandlerType, typename MonitorType>
+    struct TMonitoredHandler {
+        HandlerType& Handler;
+        MonitorType& Monitor;
+
+        void operator ()(TActor* actor, TEventPtr& event, const TActorContext& context) {
+            int mailbox = actor->Size + 1;
+            unsigned long start = micros();
+            Handler(actor, event, context);
+            Monitor.OnDispatch(actor, mailbox, micros() - start);
+        }
+
+        void operator ()(TActor* actor, TTimer& timer, const TActorContext& context) {
+            int mailbox = actor->Size + 1;
+            unsigned long start = micros();
+            Handler(actor, timer, context);
+            Monitor.OnDispatch(actor, mailbox, micros() - start);
+        }
+
+        void operator ()(TActor* actor, TEventBatch& batch, const TActorContext& context) {
+            int events = batch.size();
+            int mailbox = actor->Size + events;
+            unsigned long start = micros();
+            Handler(actor, batch, context);
+            Monitor.OnDispatch(actor, mailbox, micros() - start, events);
+        }
+    };
+
+    // one pass over the ready actors, handler delivers an event to an actor
+    template <typename HandlerType>
+    void Sweep(HandlerType& handler);
 };
 
+template <typename MonitorType>
+void TActorLib::Run(MonitorType& monitor) {
+    TVirtualHandler handler;
+    if (MonitorType::Enabled) {
+        MonitoredSweep(handler, monitor);
+    } else {
+        Sweep(handler);
+    }
+}
+
+template <typename HandlerType>
+void TActorLib::Sweep(HandlerType& handler) {
+    TActorContext context(*this);
+    CallHandler = &OnCall<HandlerType>;
+    CallHandlerTarget = &handler;
+    TActor* itActor = BeginSweep(context);
+    // urgent actors cut in once per actor of the sweep, so those resending
+    // to themselves can't hold it up
+    uint8_t urgent = 0;
+    while (itActor != nullptr) {
+        wdt_reset();
+        TActor* nextActor = itActor->NextReady;
+        itActor->NextReady = nullptr;
+        itActor->Ready = false;
+        auto& events(itActor->Events);
+        // events queued during the turn wait for the next sweep
+        uint16_t count = itActor->Size < itActor->Budget ? itActor->Size : itActor->Budget;
+        unsigned long start = itActor->BudgetMicros != 0 ? micros() : 0;
+        while (count != 0) {
+            TEvent* handled = events.front().Get();
+            itActor->Running = true;
+            if (IsTick(handled)) {
+                // armed again first, so OnTimer may cancel or move it
+                TTimer* timer = handled->Timer;
+                Rearm(Pop(itActor), context);
+                handler(itActor, *timer, context);
+                --count;
+            } else if (itActor->Batched) {
+                TEventBatch batch;
+                do {
+                    batch.push_back(Pop(itActor));
+                } while (--count != 0 && !events.empty() && !IsTick(events.front().Get()));
+                handler(itActor, batch, context);
+            } else {
+                TEventPtr event = Pop(itActor);
+                handler(itActor, event, context);
+                --count;
+            }
+            itActor->Running = false;
+            if (events.empty() || events.front().Get() == handled) {
+                // resent to the front by its own handler, retried next sweep
+                break;
+            }
+            if (itActor->BudgetMicros != 0 && micros() - start >= itActor->BudgetMicros) {
+                break;
+            }
+        }
+        if (!events.empty()) {
+            MakeReady(itActor);
+        }
+        if (urgent != 0) {
+            --urgent;
+        } else if (nextActor != nullptr && ReadyBegin != nullptr) {
+            nextActor = TakeUrgent(nextActor, urgent);
+        }
+        itActor = nextActor;
+    }
+    CallHandler = nullptr;
+    CallHandlerTarget = nullptr;
+    EndSweep();
+}
+
 template <typename Type, int WindowSize = 10>
 class TAverage {
 public:
@@ -1039,7 +1821,6 @@ struct TDefaultEnvironment {
 //    Pin<P> LedPin;
 //};
 
-#include "StringBuf.h"
 #include "Stream.h"
 #include "Serial.h"
 #include "Bluetooth.h"
@@ -1047,32 +1828,197 @@ struct TDefaultEnvironment {
 #include "Led.h"
 #include "Sensors.h"
 
-//template <typename...>
-//class TArduinoChain;
-//
-//template <typename ActivityType>
-//class TArduinoChain<ActivityType> : public ActivityType {
-//public:
-//    void Loop(const ActivityContext& context) {
-//        ActivityType::OnLoop(context);
-//    }
-//};
-//
-//template <typename ActivityType, typename... ActivityTypes>
-//class TArduinoChain<ActivityType, ActivityTypes...> : public TArduinoChain<ActivityType>, public TArduinoChain<ActivityTypes...> {
-//public:
-//    void Loop(const ActivityContext& context) {
-//        TArduinoChain<ActivityType>::Loop(context);
-//        TArduinoChain<ActivityTypes...>::Loop(context);
-//    }
-//};
-//
-//template <typename... ActivityTypes>
-//class TArduinoWorkflow : public TArduinoChain<ActivityTypes...> {
-//public:
-//    void Loop() {
-//        ActivityContext context;
-//        TArduinoChain<ActivityTypes...>::Loop(context);
-//    }
-//};
-//
+namespace AW {
+
+// constructs ActorType with pointers to other actors of a TArduinoWorkflow,
+// given by their indexes, instead of default constructing it:
+//     TArduinoWorkflow<TOwner, TSerial, TArduinoWired<TBluetoothActor<TBluetoothHC05>, 0, 1>>
+// constructs TBluetoothActor(&Get<0>(), &Get<1>()). Get returns the ActorType
+template <typename ActorType, int... Indexes>
+struct TArduinoWired {};
+
+template <int... Indexes>
+struct TArduinoIndexes {};
+
+template <typename ActorType>
+struct TArduinoWiring {
+    using TType = ActorType;
+    using TIndexes = TArduinoIndexes<>;
+};
+
+template <typename ActorType, int... Indexes>
+struct TArduinoWiring<TArduinoWired<ActorType, Indexes...>> {
+    using TType = ActorType;
+    using TIndexes = TArduinoIndexes<Indexes...>;
+};
+
+template <int Index, typename WiredType>
+class TArduinoNode;
+
+template <int Index, typename WiredType>
+typename TArduinoWiring<WiredType>::TType& GetArduinoNode(TArduinoNode<Index, WiredType>& node);
+
+// static actor set: actors are constructed in place, bootstrapped and
+// dispatched without the Register list and without virtual calls. it is not
+// smaller: the handlers get inlined into the dispatch while the vtables every
+// TActor has stay, and on the host it is no faster either
+template <int Index, typename WiredType>
+class TArduinoNode {
+protected:
+    using ActorType = typename TArduinoWiring<WiredType>::TType;
+
+    // a member, not a base, so the chain itself has no vtables
+    ActorType Actor;
+
+    template <typename WorkflowType>
+    explicit TArduinoNode(WorkflowType& workflow)
+        : TArduinoNode(workflow, typename TArduinoWiring<WiredType>::TIndexes())
+    {}
+
+    template <typename WorkflowType, int... Indexes>
+    TArduinoNode(WorkflowType& workflow, TArduinoIndexes<Indexes...>)
+        : Actor(&GetArduinoNode<Indexes>(workflow)...)
+    {
+        (void)workflow;
+    }
+
+    TActor* NodeActor() {
+        return &Actor;
+    }
+
+    void NodeDispatch(TEventPtr& event, const TActorContext& context) {
+        TEventHandlerAccess::Dispatch(Actor, event, context);
+    }
+
+    void NodeTimer(TTimer& timer, const TActorContext& context) {
+        TEventHandlerAccess::Timer(Actor, timer, context);
+    }
+
+    void NodeBatch(TEventBatch& batch, const TActorContext& context) {
+        TEventHandlerAccess::Batch(Actor, batch, context);
+    }
+
+    template <int NodeIndex, typename NodeType>
+    friend typename TArduinoWiring<NodeType>::TType& GetArduinoNode(TArduinoNode<NodeIndex, NodeType>& node);
+};
+
+template <int Index, typename... ActorTypes>
+class TArduinoChain;
+
+// every actor an event goes to is one of the workflow, nothing is left to
+// dispatch virtually
+template <int Index>
+class TArduinoChain<Index> {
+protected:
+    template <typename WorkflowType>
+    explicit TArduinoChain(WorkflowType&) {}
+
+    void ChainBootstrap(TActorLib&) {}
+    void ChainDispatch(TActor*, TEventPtr&, const TActorContext&) {}
+    void ChainTimer(TActor*, TTimer&, const TActorContext&) {}
+    void ChainBatch(TActor*, TEventBatch&, const TActorContext&) {}
+};
+
+template <int Index, typename ActorType, typename... ActorTypes>
+class TArduinoChain<Index, ActorType, ActorTypes...> : public TArduinoNode<Index, ActorType>, public TArduinoChain<Index + 1, ActorTypes...> {
+protected:
+    using TNode = TArduinoNode<Index, ActorType>;
+    using TNext = TArduinoChain<Index + 1, ActorTypes...>;
+
+    template <typename WorkflowType>
+    explicit TArduinoChain(WorkflowType& workflow)
+        : TNode(workflow)
+        , TNext(workflow)
+    {}
+
+    void ChainBootstrap(TActorLib& actorLib) {
+        actorLib.Bootstrap(TNode::NodeActor());
+        TNext::ChainBootstrap(actorLib);
+    }
+
+    void ChainDispatch(TActor* actor, TEventPtr& event, const TActorContext& context) {
+        if (actor == TNode::NodeActor()) {
+            TNode::NodeDispatch(event, context);
+        } else {
+            TNext::ChainDispatch(actor, event, context);
+        }
+    }
+
+    void ChainTimer(TActor* actor, TTimer& timer, const TActorContext& context) {
+        if (actor == TNode::NodeActor()) {
+            TNode::NodeTimer(timer, context);
+        } else {
+            TNext::ChainTimer(actor, timer, context);
+        }
+    }
+
+    void ChainBatch(TActor* actor, TEventBatch& batch, const TActorContext& context) {
+        if (actor == TNode::NodeActor()) {
+            TNode::NodeBatch(batch, context);
+        } else {
+            TNext::ChainBatch(actor, batch, context);
+        }
+    }
+};
+
+template <int Index, typename WiredType>
+typename TArduinoWiring<WiredType>::TType& GetArduinoNode(TArduinoNode<Index, WiredType>& node) {
+    return node.Actor;
+}
+
+// events may only go to the actors of the set, Register is not available
+template <typename... ActorTypes>
+class TArduinoWorkflow : public TActorLib, public TArduinoChain<0, ActorTypes...> {
+    using TChain = TArduinoChain<0, ActorTypes...>;
+    using TActorLib::Register;
+
+public:
+    TArduinoWorkflow()
+        : TChain(*this)
+    {}
+
+    // call from setup()
+    void Begin() {
+        TChain::ChainBootstrap(*this);
+        wdt_enable(WDTO_8S);
+    }
+
+    void Run() {
+        TSweepHandler handler = { this };
+        TActorLib::Sweep(handler);
+    }
+
+    template <typename MonitorType>
+    void Run(MonitorType& monitor) {
+        TSweepHandler handler = { this };
+        if (MonitorType::Enabled) {
+            TActorLib::MonitoredSweep(handler, monitor);
+        } else {
+            TActorLib::Sweep(handler);
+        }
+    }
+
+    template <int Index>
+    auto Get() -> decltype(GetArduinoNode<Index>(*this)) {
+        return GetArduinoNode<Index>(*this);
+    }
+
+protected:
+    struct TSweepHandler {
+        TArduinoWorkflow* Workflow;
+
+        void operator ()(TActor* actor, TEventPtr& event, const TActorContext& context) {
+            Workflow->TChain::ChainDispatch(actor, event, context);
+        }
+
+        void operator ()(TActor* actor, TTimer& timer, const TActorContext& context) {
+            Workflow->TChain::ChainTimer(actor, timer, context);
+        }
+
+        void operator ()(TActor* actor, TEventBatch& batch, const TActorContext& context) {
+            Workflow->TChain::ChainBatch(actor, batch, context);
+        }
+    };
+};
+
+}
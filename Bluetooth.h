@@ -7,7 +7,7 @@
 namespace AW {
 
 template <typename BluetoothType>
-class TBluetoothActor : public TActor {
+class TBluetoothActor : public TActorHandlers<TBluetoothActor<BluetoothType>, TEventBootstrap, TEventSerialData, TEventReceive> {
 public:
     TBluetoothActor(TActor* owner, TActor* serial)
         : Owner(owner)
@@ -28,33 +28,24 @@ protected:
     TActor* Serial;
     BluetoothType Bluetooth;
 
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventSerialData::EventID:
-            return OnSerialData(static_cast<TEventSerialData*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
         Bluetooth.Init(context);
     }
 
-    void OnSerialData(TUniquePtr<TEventSerialData> event, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventSerialData> event, const TActorContext& context) {
         //::Serial.println("== ");
         if (event->Sender == Serial) {
             if (!Bluetooth.Receive(event, context)) {
-                context.Send(this, Owner, event.Release());
+                context.Call(this, Owner, event.Release());
             }
         } else {
-            context.Send(this, Serial, event.Release());
+            context.Call(this, Serial, event.Release());
         }
     }
 
-    void OnReceive(TUniquePtr<TEventReceive> event, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventReceive> event, const TActorContext& context) {
         Bluetooth.Receive(event, context);
     }
 };
@@ -4,7 +4,7 @@
 
 namespace AW {
 
-class DisplaySSD1306 : public TActor {
+class DisplaySSD1306 : public TActorHandlers<DisplaySSD1306, TEventBootstrap, TEventSerialData> {
 public:
     void SetContrast(uint8_t contrast) {
         if (DisplayFound) {
@@ -28,16 +28,9 @@ protected:
     SSD1306AsciiWire Display;
     bool DisplayFound = false;
 
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventSerialData::EventID:
-            return OnSerialData(static_cast<TEventSerialData*>(event.Release()), context);
-        }
-    }
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext&/* context*/) {
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext&/* context*/) {
         static const uint8_t address = 0x3c;
         TWire::BeginTransmission(address);
         if (TWire::EndTransmission()) {
@@ -49,7 +42,7 @@ protected:
         }
     }
 
-    void OnSerialData(TUniquePtr<TEventSerialData> event, const TActorContext&/* context*/) {
+    void Handle(TUniquePtr<TEventSerialData> event, const TActorContext&/* context*/) {
         if (DisplayFound) {
             for (unsigned int i = 0; i < event->Data.size(); ++i) {
                 Display.write(event->Data[i]);
@@ -0,0 +1,128 @@
+#pragma once
+
+// TIdleAVR is not part of ArduinoWorkflow.h: it takes the watchdog interrupt
+// and patches the timer0 bookkeeping of the Arduino AVR core, which other
+// cores and sleep libraries don't share. a sketch opts in by including this
+// header, from one of its files only
+
+#include "ArduinoWorkflow.h"
+
+#if !defined(ARDUINO_ARCH_AVR) || !defined(WDTCSR) || !(defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) \
+    || defined(__AVR_ATmega168P__) || defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__))
+#error "TIdleAVR supports the ATmega boards of the Arduino AVR core only"
+#endif
+
+#include <avr/sleep.h>
+
+// Arduino core's timer0 bookkeeping behind millis() and micros()
+extern volatile unsigned long timer0_overflow_count;
+extern volatile unsigned long timer0_millis;
+
+// with WDIE set the watchdog interrupts first, which clears WDIE, and only
+// resets on the next timeout
+EMPTY_INTERRUPT(WDT_vect);
+
+namespace AW {
+
+// idle sleep mode: timers and peripherals keep running. the timer0 tick only
+// keeps the clock, any other interrupt ends the sleep.
+// deep: waits of 16 ms and more power down, timed by the watchdog in 16 ms
+// to 8 s steps. the clock is stopped and advanced by the watchdog period,
+// which is only as accurate as its oscillator. the UARTs stop too, so only
+// pin and TWI interrupts end such a sleep early, and the time slept until
+// then is lost
+class TIdleAVR : public TIdle {
+public:
+    TIdleAVR(bool deep = false)
+        : Deep(deep)
+    {}
+
+    void Sleep(TTime duration) override {
+        TTime start = TTime::Now();
+        if (Deep) {
+            for (;;) {
+                TTime slept = TTime::Now() - start;
+                if (Woken || !(slept < duration) || !PowerDown(duration - slept)) {
+                    break;
+                }
+            }
+        }
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        for (;;) {
+            wdt_reset();
+            cli();
+            if (Woken || !(TTime::Now() - start < duration)) {
+                sei();
+                break;
+            }
+            unsigned long ticks = timer0_overflow_count;
+            // sei takes effect after the next instruction, no interrupt can
+            // slip in between the check and the sleep
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+            cli();
+            bool tick = timer0_overflow_count != ticks;
+            sei();
+            if (!tick) {
+                break;
+            }
+        }
+        Woken = false;
+    }
+
+protected:
+    bool Deep;
+
+    // sleeps one watchdog period not longer than the duration, false if
+    // the duration is too short for it
+    bool PowerDown(TTime duration) {
+        // 16 ms << prescaler, up to 8 s
+        uint8_t prescaler = 0;
+        while (prescaler < 9 && (16000ull << (prescaler + 1)) <= duration.MicroSeconds()) {
+            ++prescaler;
+        }
+        uint32_t period = 16000ul << prescaler;
+        if (duration.MicroSeconds() < period) {
+            return false;
+        }
+        Serial.flush();
+        uint8_t bits = (prescaler & 7) | ((prescaler & 8) ? _BV(WDP3) : 0);
+        set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+        cli();
+        if (Woken) {
+            sei();
+            return false;
+        }
+        uint8_t watchdog = WDTCSR;
+        wdt_reset();
+        WDTCSR = _BV(WDCE) | _BV(WDE);
+        WDTCSR = _BV(WDIE) | _BV(WDE) | bits;
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+        cli();
+        bool timed = !(WDTCSR & _BV(WDIE));
+        wdt_reset();
+        WDTCSR = _BV(WDCE) | _BV(WDE);
+        WDTCSR = watchdog & ~_BV(WDIE);
+        if (timed) {
+            // micros() counts whole timer0 overflows, carry the rest over
+            static uint16_t carry = 0;
+            const uint16_t overflow = 64 * 256 / clockCyclesPerMicrosecond();
+            uint32_t us = period + carry;
+            timer0_millis += period / 1000;
+            timer0_overflow_count += us / overflow;
+            carry = us % overflow;
+        } else {
+            // some other interrupt, there may be work
+            Woken = true;
+        }
+        sei();
+        return timed;
+    }
+};
+
+}
@@ -3,56 +3,49 @@
 namespace AW {
 
 struct TEventLedOn : TBasicEvent<TEventLedOn> {
-    constexpr static TEventID EventID = 3; // TODO
+    constexpr static TEventID EventID = EventLedOn;
 };
 
 struct TEventLedOff : TBasicEvent<TEventLedOff> {
-    constexpr static TEventID EventID = 4; // TODO
+    constexpr static TEventID EventID = EventLedOff;
 };
 
 struct TEventLedBlink : TBasicEvent<TEventLedBlink> {
-    constexpr static TEventID EventID = 5; // TODO
+    constexpr static TEventID EventID = EventLedBlink;
     int Period;
 
     TEventLedBlink(int period)
         : Period(period) {}
 };
 
-class TLedActor : public TActor {
+class TLedActor : public TActorHandlers<TLedActor, TEventLedOn, TEventLedOff, TEventLedBlink, TEventReceive> {
 protected:
     TPin<LED_BUILTIN> LedPin;
     bool Led = false;
+    TTimer Blink;
 
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventLedOn::EventID:
-            return OnLedOn(static_cast<TEventLedOn*>(event.Release()), context);
-        case TEventLedOff::EventID:
-            return OnLedOff(static_cast<TEventLedOff*>(event.Release()), context);
-        case TEventLedBlink::EventID:
-            return OnLedBlink(static_cast<TEventLedBlink*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    friend struct TEventHandlerAccess;
 
-    void OnLedOn(TUniquePtr<TEventLedOn>, const TActorContext&) {
+    void Handle(TUniquePtr<TEventLedOn>, const TActorContext& context) {
+        context.Cancel(Blink);
         LedPin = Led = true;
     }
 
-    void OnLedOff(TUniquePtr<TEventLedOff>, const TActorContext&) {
+    void Handle(TUniquePtr<TEventLedOff>, const TActorContext& context) {
+        context.Cancel(Blink);
         LedPin = Led = false;
     }
 
-    void OnLedBlink(TUniquePtr<TEventLedBlink> event, const TActorContext& context) {
+    // blinks while on are ignored, so there is one pending switch off at most
+    void Handle(TUniquePtr<TEventLedBlink> event, const TActorContext& context) {
         if (!Led) {
-            context.Send(this, this, new TEventReceive());
-            context.Send(this, this, new TEventReceive(context.Now + TTime::MilliSeconds(event->Period)));
+            LedPin = Led = true;
+            context.Schedule(Blink, this, context.Now + TTime::MilliSeconds(event->Period));
         }
     }
 
-    void OnReceive(TUniquePtr<TEventReceive> /*event*/, const TActorContext& /*context*/) {
-        LedPin = Led = !Led;
+    void Handle(TUniquePtr<TEventReceive> /*event*/, const TActorContext& /*context*/) {
+        LedPin = Led = false;
     }
 };
 
@@ -4,8 +4,8 @@
 
 namespace AW {
 
-template <uint8_t Address = 0x5c, uint8_t PowerPin = -1, typename WireType = TWire>
-class TSensorAM2320 : public TActor {
+template <uint8_t Address = 0x5c, uint8_t PowerPin = 0xff, typename WireType = TWire>
+class TSensorAM2320 : public TActorHandlers<TSensorAM2320<Address, PowerPin, WireType>, TEventBootstrap, TEventReceive> {
 public:
     TActor* Owner;
     TTime Period = TTime::MilliSeconds(8000);
@@ -26,25 +26,20 @@ public:
     }
 
 protected:
-    static constexpr auto PowerOnDelay = TTime::MilliSeconds(1200);
+    static constexpr TTime PowerOnDelay = TTime::MilliSeconds(1200);
+    static constexpr TTime ReadDelay = TTime::MicroSeconds(3000);
     WireType Wire;
     bool Powered = false;
+    bool Requested = false;
     TPin<PowerPin> Power;
     unsigned long Errors = 0;
 
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    friend struct TEventHandlerAccess;
 
     void PowerOn() {
         if (!Powered) {
             Powered = true;
-            if (PowerPin != -1) {
+            if (PowerPin != 0xff) {
                 Power = Powered;
             }
         }
@@ -53,22 +48,22 @@ protected:
     void PowerOff() {
         if (Powered) {
             Powered = false;
-            if (PowerPin != -1) {
+            if (PowerPin != 0xff) {
                 Power = Powered;
             }
         }
     }
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
         for (auto tries = 0; tries < 2; ++tries) {
             PowerOn();
             delay(PowerOnDelay.MilliSeconds());
             Wire.BeginTransmission(Address);
             Wire.EndTransmission();
             Wire.BeginTransmission(Address);
-            Wire.Write(0x03);
-            Wire.Write(0x08);
-            Wire.Write(0x02);
+            Wire.Write(uint8_t(0x03));
+            Wire.Write(uint8_t(0x08));
+            Wire.Write(uint8_t(0x02));
             if (Wire.EndTransmission()) {
                 delayMicroseconds(1600);
                 if (Wire.RequestFrom(Address, 0x06) == 0x06) {
@@ -82,7 +77,7 @@ protected:
                     Wire.Read(crc16);
                     if (code == 0x03 && length == 0x02) {
                         context.Send(this, this, new AW::TEventReceive(context.Now + Period));
-                        context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "AM2320 on " << String(Address, 16)));
+                        context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "AM2320 on " << String(Address, 16)));
                         break;
                     }
                 }
@@ -124,7 +119,9 @@ protected:
         uint16_t Temperature;
     };
 
-    void OnReceive(AW::TUniquePtr<AW::TEventReceive> event, const AW::TActorContext& context) {
+    // a reading takes two events: the command wakes the sensor up, the data
+    // is fetched ReadDelay later without blocking the loop in between
+    void Handle(AW::TUniquePtr<AW::TEventReceive> event, const AW::TActorContext& context) {
         if (!Powered) {
             PowerOn();
             event->NotBefore = context.Now + PowerOnDelay;
@@ -133,76 +130,82 @@ protected:
         }
         auto timeout = Period;
         bool good = false;
-        //Wire.BeginTransmission(Address);
-//		delayMicroseconds(1600);
-        //Wire.EndTransmission();
-        for (auto tries = 0; tries < 1; ++tries) {
-            //delayMicroseconds(30);
+        if (!Requested) {
             Wire.BeginTransmission(Address);
             Wire.EndTransmission(false);
-            //delayMicroseconds(800);
             Wire.BeginTransmission(Address);
-            Wire.Write(0x03);
-            Wire.Write(0x00);
-            Wire.Write(0x04);
+            Wire.Write(uint8_t(0x03));
+            Wire.Write(uint8_t(0x00));
+            Wire.Write(uint8_t(0x04));
             if (Wire.EndTransmission()) {
-                delayMicroseconds(3000);
-                if (Wire.RequestFrom(Address, 0x08) == 0x08) {
-                    TData data;
-                    uint16_t crc16;
-                    Wire.Read(data);
-                    Wire.Read(crc16);
-                    bswap(crc16);
-                    if (data.Code != 0x03) {
-                        /*StringStream stream;
-                        stream << "AM2320 wrong Code (" << data.Code << ")";
-                        context.Send(this, Owner, new AW::TEventSensorMessage(stream));
-                        stream.clear();
-                        stream << data.Code << " vs " << 3;
-                        context.Send(this, Owner, new AW::TEventSensorMessage(stream));*/
-                        //timeout = TTime::MilliSeconds(2000);
-                    } else if (data.Length != 4) {
-                        /*StringStream stream;
-                        stream << "AM2320 wrong Length";
-                        context.Send(this, Owner, new AW::TEventSensorMessage(stream));
-                        stream.clear();
-                        stream << data.Length << " vs " << 4;
-                        context.Send(this, Owner, new AW::TEventSensorMessage(stream));*/
-                        //timeout = TTime::MilliSeconds(2000);
-                    } else if (CRC16(data) != crc16) {
-                        /*StringStream stream;
-                        stream << "AM2320 wrong CRC16";
-                        context.Send(this, Owner, new AW::TEventSensorMessage(stream));
-                        stream.clear();
-                        stream << String(crc16, 16) << " vs " << String(CRC16(data), 16);
-                        context.Send(this, Owner, new AW::TEventSensorMessage(stream));*/
-                        //timeout = TTime::MilliSeconds(2000);
-                    } else {
-                        bswap(data.Temperature);
-                        bswap(data.Humidity);
-                        Sensor.Values[ESensor::Temperature].Value = (float)data.Temperature / 10;
-                        Sensor.Values[ESensor::Humidity].Value = (float)data.Humidity / 10;
-                        Sensor.Updated = context.Now;
-                        if (SendValues) {
-                            context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Temperature]));
-                            context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Humidity]));
-                        }
-                        good = true;
+                // the data is only there for a while after the command
+                Requested = true;
+                event->Priority = EPriority::High;
+                event->NotBefore = context.Now + ReadDelay;
+                context.Resend(this, event.Release());
+                return;
+            }
+        } else {
+            Requested = false;
+            event->Priority = EPriority::Normal;
+            if (Wire.RequestFrom(Address, 0x08) == 0x08) {
+                TData data;
+                uint16_t crc16;
+                Wire.Read(data);
+                Wire.Read(crc16);
+                bswap(crc16);
+                if (data.Code != 0x03) {
+                    /*StringStream stream;
+                    stream << "AM2320 wrong Code (" << data.Code << ")";
+                    context.Send(this, Owner, new AW::TEventSensorMessage(stream));
+                    stream.clear();
+                    stream << data.Code << " vs " << 3;
+                    context.Send(this, Owner, new AW::TEventSensorMessage(stream));*/
+                    //timeout = TTime::MilliSeconds(2000);
+                } else if (data.Length != 4) {
+                    /*StringStream stream;
+                    stream << "AM2320 wrong Length";
+                    context.Send(this, Owner, new AW::TEventSensorMessage(stream));
+                    stream.clear();
+                    stream << data.Length << " vs " << 4;
+                    context.Send(this, Owner, new AW::TEventSensorMessage(stream));*/
+                    //timeout = TTime::MilliSeconds(2000);
+                } else if (CRC16(data) != crc16) {
+                    /*StringStream stream;
+                    stream << "AM2320 wrong CRC16";
+                    context.Send(this, Owner, new AW::TEventSensorMessage(stream));
+                    stream.clear();
+                    stream << String(crc16, 16) << " vs " << String(CRC16(data), 16);
+                    context.Send(this, Owner, new AW::TEventSensorMessage(stream));*/
+                    //timeout = TTime::MilliSeconds(2000);
+                } else {
+                    bswap(data.Temperature);
+                    bswap(data.Humidity);
+                    Sensor.Values[ESensor::Temperature].Value = (float)data.Temperature / 10;
+                    Sensor.Values[ESensor::Humidity].Value = (float)data.Humidity / 10;
+                    Sensor.Updated = context.Now;
+                    if (SendValues) {
+                        context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Temperature]));
+                        context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Humidity]));
                     }
+                    good = true;
                 }
             }
-            if (good) {
-                break;
-            }
         }
         if (!good) {
             PowerOff();
-            timeout = TTime::MilliSeconds(Period - PowerOnDelay.MilliSeconds());
-            context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "error " << ++Errors));
+            timeout = Period - PowerOnDelay;
+            context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "error " << ++Errors));
         }
         event->NotBefore = context.Now + timeout;
         context.Resend(this, event.Release());
     }
 };
 
+template <uint8_t Address, uint8_t PowerPin, typename WireType>
+constexpr TTime TSensorAM2320<Address, PowerPin, WireType>::PowerOnDelay;
+
+template <uint8_t Address, uint8_t PowerPin, typename WireType>
+constexpr TTime TSensorAM2320<Address, PowerPin, WireType>::ReadDelay;
+
 }	
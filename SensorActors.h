@@ -0,0 +1,122 @@
+#pragma once
+
+#include "ArduinoWorkflow.h"
+
+namespace AW {
+
+// runtime counters of watched actors, collected when loop() calls lib.Run(sensor).
+// register it with sensor.Register(lib). without Env::Diagnostics it is an
+// empty class and every call on it compiles to nothing
+template <int Count, typename Env = TDefaultEnvironment, bool Diagnostics = Env::Diagnostics>
+class TSensorActors : public TActorHandlers<TSensorActors<Count, Env, Diagnostics>, TEventBootstrap> {
+public:
+    static constexpr bool Enabled = true;
+
+    TActor* Owner;
+    TTime Period = Env::SensorsPeriod;
+    TSensor<6> Sensors[Count];
+
+    enum ESensor {
+        Events,
+        Micros,
+        MaxMicros,
+        MaxMailbox,
+        Deferred,
+        Dropped
+    };
+
+    TSensorActors(TActor* owner)
+        : Owner(owner)
+    {}
+
+    void Register(TActorLib& actorLib) {
+        actorLib.Register(this);
+    }
+
+    void Watch(TActor* actor, StringBuf name) {
+        if (Watched < Count) {
+            TSensor<6>& sensor(Sensors[Watched]);
+            sensor.Name = name;
+            sensor.Values[ESensor::Events].Name = "events";
+            sensor.Values[ESensor::Micros].Name = "micros";
+            sensor.Values[ESensor::MaxMicros].Name = "maxmicros";
+            sensor.Values[ESensor::MaxMailbox].Name = "maxmailbox";
+            sensor.Values[ESensor::Deferred].Name = "deferred";
+            sensor.Values[ESensor::Dropped].Name = "dropped";
+            Actors[Watched] = actor;
+            Counters[Watched] = TCounters();
+            ++Watched;
+        }
+    }
+
+    void OnDispatch(TActor* actor, int mailbox, unsigned long micros, int events = 1) {
+        for (int i = 0; i < Watched; ++i) {
+            if (Actors[i] == actor) {
+                TCounters& counters(Counters[i]);
+                counters.Events += events;
+                counters.Micros += micros;
+                if (micros > counters.MaxMicros) {
+                    counters.MaxMicros = micros;
+                }
+                if (mailbox > counters.MaxMailbox) {
+                    counters.MaxMailbox = mailbox;
+                }
+                return;
+            }
+        }
+    }
+
+protected:
+    // events and micros are totals, maximums restart every period
+    struct TCounters {
+        unsigned long Events = 0;
+        unsigned long Micros = 0;
+        unsigned long MaxMicros = 0;
+        int MaxMailbox = 0;
+    };
+
+    TActor* Actors[Count];
+    TCounters Counters[Count];
+    int Watched = 0;
+    TTimer Timer;
+
+    friend struct TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        context.Start(Timer, this, Period);
+    }
+
+    void OnTimer(TTimer&, const TActorContext& context) override {
+        for (int i = 0; i < Watched; ++i) {
+            TSensor<6>& sensor(Sensors[i]);
+            TCounters& counters(Counters[i]);
+            sensor.Values[ESensor::Events].Value = counters.Events;
+            sensor.Values[ESensor::Micros].Value = counters.Micros;
+            sensor.Values[ESensor::MaxMicros].Value = counters.MaxMicros;
+            sensor.Values[ESensor::MaxMailbox].Value = counters.MaxMailbox;
+            sensor.Values[ESensor::Deferred].Value = context.ActorLib.GetDeferred(Actors[i]);
+            sensor.Values[ESensor::Dropped].Value = Actors[i]->GetDropped();
+            sensor.Updated = context.Now;
+            counters.MaxMicros = 0;
+            counters.MaxMailbox = 0;
+            if (Env::SensorsSendValues) {
+                for (const TSensorValue& value : sensor.Values) {
+                    context.Send(this, Owner, new TEventSensorData(sensor, value));
+                }
+            }
+        }
+    }
+};
+
+template <int Count, typename Env>
+class TSensorActors<Count, Env, false> {
+public:
+    static constexpr bool Enabled = false;
+
+    TSensorActors(TActor*) {}
+    void Register(TActorLib&) {}
+    void Watch(TActor*, StringBuf) {}
+    void OnDispatch(TActor*, int, unsigned long, int = 1) {}
+};
+
+}
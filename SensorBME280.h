@@ -5,7 +5,7 @@
 namespace AW {
 
 template <uint8_t Address = 0x77, typename Env = TDefaultEnvironment>
-class TSensorBME280 : public TActor {
+class TSensorBME280 : public TActorHandlers<TSensorBME280<Address, Env>, TEventBootstrap> {
     static constexpr uint8_t ChipID = 0x60;
 
     enum ERegisters : uint8_t {
@@ -206,16 +206,11 @@ public:
     }
 
 protected:
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    TTimer Timer;
+
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
         uint8_t chipID = Read8(ERegisters::BME280_REGISTER_CHIPID);
         if (chipID == ChipID) {
             /*
@@ -251,9 +246,9 @@ protected:
             Write8(BME280_REGISTER_CONFIG, _configReg.get());
             Write8(BME280_REGISTER_CONTROL, _measReg.get());
 
-            context.Send(this, this, new AW::TEventReceive(context.Now + Env::SensorsPeriod));
+            context.Start(Timer, this, Env::SensorsPeriod);
             if (Env::Diagnostics) {
-                context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "BME280 on " << String(Address, 16)));
+                context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "BME280 on " << String(Address, 16)));
             }
         }
 
@@ -384,7 +379,7 @@ protected:
         Env::Wire::ReadValue(Address, BME280_REGISTER_DIG_H6, data.dig_H6);*/
     }
 
-    void OnReceive(AW::TUniquePtr<AW::TEventReceive> event, const AW::TActorContext& context) {
+    void OnTimer(TTimer&, const TActorContext& context) override {
         BME280CalibData calib;
         ReadCoefficients(calib);
         int32_t t_fine;
@@ -457,8 +452,6 @@ protected:
             context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Pressure]));
             context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Humidity]));
         }
-        event->NotBefore = context.Now + Env::SensorsPeriod;
-        context.Resend(this, event.Release());
     }
 };
 
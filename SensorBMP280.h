@@ -5,7 +5,7 @@
 namespace AW {
 
 template <uint8_t Address = 0x77, typename Env = TDefaultEnvironment>
-class TSensorBMP280 : public TActor {
+class TSensorBMP280 : public TActorHandlers<TSensorBMP280<Address, Env>, TEventBootstrap> {
     static constexpr uint8_t ChipID = 0x58;
 
     struct ERegisters {
@@ -80,22 +80,17 @@ public:
     }
 
 protected:
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    TTimer Timer;
+
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
         uint8_t chipID = Read8(ERegisters::BMP280_REGISTER_CHIPID);
         if (chipID == ChipID) {
             Env::Wire::WriteValue(Address, ERegisters::BMP280_REGISTER_CONTROL, EFlags::BMP280_RESET);
-            context.Send(this, this, new AW::TEventReceive(context.Now + Env::SensorsPeriod));
+            context.Start(Timer, this, Env::SensorsPeriod);
             if (Env::Diagnostics) {
-                context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "BMP280 on " << String(Address, 16)));
+                context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "BMP280 on " << String(Address, 16)));
             }
         }
 
@@ -175,7 +170,7 @@ protected:
         data.dig_P9 = ReadS16LE(ERegisters::BMP280_REGISTER_DIG_P9);
     }
 
-    void OnReceive(AW::TUniquePtr<AW::TEventReceive> event, const AW::TActorContext& context) {
+    void OnTimer(TTimer&, const TActorContext& context) override {
         BMP280CalibData calib;
         ReadCoefficients(calib);
         int32_t t_fine;
@@ -227,8 +222,6 @@ protected:
             context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Temperature]));
             context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Pressure]));
         }
-        event->NotBefore = context.Now + Env::SensorsPeriod;
-        context.Resend(this, event.Release());
     }
 };
 
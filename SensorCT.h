@@ -6,7 +6,7 @@
 namespace AW {
 
 template <uint8_t Pin>
-class TSensorCT : public TActor {
+class TSensorCT : public TActorHandlers<TSensorCT<Pin>, TEventBootstrap> {
 public:
     TActor* Owner;
     TTime Period = AW::TTime::MilliSeconds(3000);
@@ -27,27 +27,19 @@ public:
 
 protected:
     EnergyMonitor EMon;
+    TTimer Timer;
 
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
-        context.Send(this, this, new AW::TEventReceive(context.Now + Period));
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        context.Start(Timer, this, Period);
     }
 
-    void OnReceive(AW::TUniquePtr<AW::TEventReceive> event, const AW::TActorContext& context) {
+    void OnTimer(TTimer&, const TActorContext& context) override {
         Sensor.Values[ESensor::Current].Value = EMon.calcIrms(1480);
         Sensor.Updated = context.Now;
         if (SendValues)
             context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Current]));
-        event->NotBefore = context.Now + Period;
-        context.Resend(this, event.Release());
     }
 };
 
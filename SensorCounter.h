@@ -5,7 +5,7 @@
 namespace AW {
 
 template <uint8_t Pin, uint16_t MinDelayLow = 500, uint16_t MinDelayHigh = 500>
-class TSensorCounter : public TActor {
+class TSensorCounter : public TActorHandlers<TSensorCounter<Pin, MinDelayLow, MinDelayHigh>, TEventBootstrap> {
 public:
     TActor* Owner;
     TTime Period = TTime::MilliSeconds(1000);
@@ -35,28 +35,22 @@ protected:
     volatile uint32_t Value;
     volatile uint32_t Low;
     volatile uint32_t High;
+    TTimer Timer;
     
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
         This() = this;
         Value = 0;
         Low = 0;
         High = 0;
         LastValue = PinValue;
-        LastTime = context.Now.MilliSeconds();
+        LastTime = millis();
         attachInterrupt(digitalPinToInterrupt(Pin), StaticInterrupt, CHANGE);
-        context.Send(this, this, new TEventReceive(context.Now + Period));
+        context.Start(Timer, this, Period);
     }
 
-    void OnReceive(TUniquePtr<TEventReceive> event, const TActorContext& context) {
+    void OnTimer(TTimer&, const TActorContext& context) override {
         if (Value != Sensor.Values[ESensor::Counter].Value) {
             Sensor.Values[ESensor::Counter].Value = Value;
             Sensor.Values[ESensor::DelayLow].Value = Low;
@@ -68,25 +62,24 @@ protected:
                 context.Send(this, Owner, new TEventSensorData(Sensor, Sensor.Values[ESensor::DelayHigh]));
             }
         }
-        event->NotBefore = context.Now + Period;
-        context.Resend(this, event.Release());
     }
 
     void Interrupt() {
         bool value = PinValue;
         if (value != LastValue) {
-            TTime now = TTime::Now();
-            TTime delay = now - TTime::MilliSeconds(LastTime);
+            // unsigned difference stays right across the millis() rollover
+            uint32_t now = millis();
+            uint32_t delay = now - LastTime;
             switch (value) {
             case false:
-                if (delay < TTime::MilliSeconds(MinDelayLow)) {
+                if (delay < MinDelayLow) {
                     LastValue = value;
                     return;
                 }
                 High = now;
                 break;
             case true:
-                if (delay < TTime::MilliSeconds(MinDelayHigh)) {
+                if (delay < MinDelayHigh) {
                     LastValue = value;
                     return;
                 }
@@ -94,7 +87,7 @@ protected:
                 ++Value;
                 break;
             }
-            LastTime = now.MilliSeconds();
+            LastTime = now;
             LastValue = value;
         }
     }
@@ -5,7 +5,7 @@
 
 namespace AW {
 
-class TSensorEnergy : public TActor {
+class TSensorEnergy : public TActorHandlers<TSensorEnergy, TEventBootstrap> {
 public:
     TActor* Owner;
     TTime Period = AW::TTime::MilliSeconds(10000);
@@ -20,28 +20,20 @@ public:
 
 protected:
     EnergyMonitor EMon;
+    TTimer Timer;
 
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
         EMon.calcVI(100, 1000);
-        context.Send(this, this, new AW::TEventReceive(context.Now + Period));
+        context.Start(Timer, this, Period);
     }
 
-    void OnReceive(AW::TUniquePtr<AW::TEventReceive> event, const AW::TActorContext& context) {
+    void OnTimer(TTimer&, const TActorContext& /*context*/) override {
         EMon.calcVI(100, 1000);
         //context.Send(this, Owner, new AW::TEventSensorData("energy.power", EMon.apparentPower));
         //context.Send(this, Owner, new AW::TEventSensorData("energy.voltage", EMon.Vrms));
         //context.Send(this, Owner, new AW::TEventSensorData("energy.current", EMon.Irms));
-        event->NotBefore = context.Now + Period;
-        context.Resend(this, event.Release());
     }
 };
 
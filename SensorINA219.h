@@ -5,7 +5,7 @@
 namespace AW {
 
 template <uint8_t Address = 0x40, typename Env = TDefaultEnvironment>
-class TSensorINA219 : public TActor {
+class TSensorINA219 : public TActorHandlers<TSensorINA219<Address, Env>, TEventBootstrap> {
     constexpr static bool UseChipCalculations = false;
 
     struct ERegisters {
@@ -101,16 +101,11 @@ public:
     }
 
 protected:
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    TTimer Timer;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+    friend struct TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
         static constexpr uint16_t ConfigValue =
             EFlags::INA219_CONFIG_BVOLTAGERANGE_16V |
             EFlags::INA219_CONFIG_GAIN_1_40MV |
@@ -123,17 +118,14 @@ protected:
                 static constexpr uint16_t CalibrationValue = 32768;
                 Env::Wire::WriteValue(Address, ERegisters::INA219_REG_CALIBRATION, CalibrationValue);
             }
-            context.Send(this, this, new AW::TEventReceive(context.Now + Env::SensorsPeriod));
+            context.Start(Timer, this, Env::SensorsPeriod);
             if (Env::Diagnostics) {
-                context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "INA219 on " << String(Address, 16)));
+                context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "INA219 on " << String(Address, 16)));
             }
         }
     }
 
-    void OnReceive(AW::TUniquePtr<AW::TEventReceive> event, const AW::TActorContext& context) {
-        event->NotBefore = context.Now + Env::SensorsPeriod;
-        context.Resend(this, event.Release());
-
+    void OnTimer(TTimer&, const TActorContext& context) override {
         uint16_t config_value = 0; // INA219_REG_CONFIG
         TConfigRegister& config(*reinterpret_cast<TConfigRegister*>(&config_value));
         
@@ -146,7 +138,7 @@ protected:
         
 
         if (Env::Diagnostics) {
-            context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "config " << String(config_value, 16)));
+            context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "config " << String(config_value, 16)));
         }
 
         static constexpr float RSHUNT = 0.1; // ohms
@@ -160,8 +152,8 @@ protected:
         float shuntValue = ((int32_t)(int16_t)shunt_voltage << config.PG) * shuntLSB;
 
         if (Env::Diagnostics) {
-            context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "bus " << String(bus_voltage_value, 16) << " (" << busValue << ")"));
-            context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "shunt " << String(shunt_voltage, 16) << " (" << shuntValue << ")"));
+            context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "bus " << String(bus_voltage_value, 16) << " (" << busValue << ")"));
+            context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "shunt " << String(shunt_voltage, 16) << " (" << shuntValue << ")"));
         }
 
         if (shunt_voltage == 0xffff || bus_voltage.OVF) { // not connected or overflowed
@@ -198,7 +190,7 @@ protected:
 
                 Env::Wire::ReadValue(Address, ERegisters::INA219_REG_CALIBRATION, calibration_value);
                 if (Env::Diagnostics) {
-                    context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "calibration " << String(calibration_value, 16)));
+                    context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "calibration " << String(calibration_value, 16)));
                 }
 
                 //float currentLSB = 0.04096 / (calibration_value * RSHUNT); // A
@@ -217,8 +209,8 @@ protected:
                 Sensor.Values[ESensor::Power].Value = powerValue;
 
                 if (Env::Diagnostics) {
-                    context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "current " << String(current_value, 16) << " (" << Sensor.Values[ESensor::Current].Value << ")"));
-                    context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, StringStream() << "power " << String(power_value, 16) << " (" << Sensor.Values[ESensor::Power].Value << ")"));
+                    context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "current " << String(current_value, 16) << " (" << Sensor.Values[ESensor::Current].Value << ")"));
+                    context.Send(this, Owner, new AW::TEventSensorMessage(Sensor, TSensorText() << "power " << String(power_value, 16) << " (" << Sensor.Values[ESensor::Power].Value << ")"));
                 }
 
                 if (Env::SensorsCalibration) {
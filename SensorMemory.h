@@ -8,7 +8,7 @@ extern void *__brkval;
 
 namespace AW {
 
-class TSensorMemory : public TActor {
+class TSensorMemory : public TActorHandlers<TSensorMemory, TEventBootstrap> {
 public:
     TActor* Owner;
     TTime Period = AW::TTime::MilliSeconds(3000);
@@ -27,34 +27,27 @@ public:
     }
 
 protected:
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    TTimer Timer;
+
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
-        context.Send(this, this, new AW::TEventReceive(context.Now + Period));
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        context.Start(Timer, this, Period);
     }
 
     static uint16_t GetFreeMemory() {
         uint16_t freeMemory;
-        if ((int)__brkval == 0)
-            return ((uint16_t)&freeMemory) - ((uint16_t)&__bss_end);
+        if (__brkval == 0)
+            return (uintptr_t)&freeMemory - (uintptr_t)&__bss_end;
         else
-            return ((uint16_t)&freeMemory) - ((uint16_t)__brkval);
+            return (uintptr_t)&freeMemory - (uintptr_t)__brkval;
     }
 
-    void OnReceive(AW::TUniquePtr<AW::TEventReceive> event, const AW::TActorContext& context) {
+    void OnTimer(TTimer&, const TActorContext& context) override {
         Sensor.Values[ESensor::Free].Value = GetFreeMemory();
         Sensor.Updated = context.Now;
         if (SendValues)
             context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Free]));
-        event->NotBefore = context.Now + Period;
-        context.Resend(this, event.Release());
     }
 };
 
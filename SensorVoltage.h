@@ -5,7 +5,7 @@
 namespace AW {
 
 template <uint8_t Pin, int Multiplier = 1, int Divider = 1>
-class TSensorVoltage : public TActor {
+class TSensorVoltage : public TActorHandlers<TSensorVoltage<Pin, Multiplier, Divider>, TEventBootstrap> {
 public:
     TActor* Owner;
     TTime Period = AW::TTime::MilliSeconds(3000);
@@ -25,28 +25,20 @@ public:
 
 protected:
     TPin<Pin, INPUT> PinValue;
+    TTimer Timer;
 
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
-        context.Send(this, this, new AW::TEventReceive(context.Now + Period));
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        context.Start(Timer, this, Period);
     }
 
-    void OnReceive(AW::TUniquePtr<AW::TEventReceive> event, const AW::TActorContext& context) {
+    void OnTimer(TTimer&, const TActorContext& context) override {
         float value = (float)PinValue.GetAveragedValue() * Multiplier / Divider;
         Sensor.Values[ESensor::Voltage].Value = value;
         Sensor.Updated = context.Now;
         if (SendValues)
             context.Send(this, Owner, new AW::TEventSensorData(Sensor, Sensor.Values[ESensor::Voltage]));
-        event->NotBefore = context.Now + Period;
-        context.Resend(this, event.Release());
     }
 };
 
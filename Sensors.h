@@ -16,7 +16,7 @@ template <size_t Count> struct TSensor : TSensorSource {
 };
 
 struct TEventSensorData : TBasicEvent<TEventSensorData> {
-    constexpr static TEventID EventID = 6; // TODO
+    constexpr static TEventID EventID = EventSensorData;
     const TSensorSource& Source;
     const TSensorValue& Value;
 
@@ -26,15 +26,21 @@ struct TEventSensorData : TBasicEvent<TEventSensorData> {
 };
 
 struct TEventSensorMessage : TBasicEvent<TEventSensorMessage> {
-    constexpr static TEventID EventID = 7; // TODO
+    constexpr static TEventID EventID = EventSensorMessage;
     const TSensorSource& Source;
-    String Message;
+    TEventString Message;
 
-    TEventSensorMessage(const TSensorSource& source, const String& message)
+    TEventSensorMessage(const TSensorSource& source, const TEventString& message)
         : Source(source)
         , Message(message) {}
 };
 
+// diagnostic lines of the sensors are formatted on the stack, the longest,
+// "current ffff (-4294967295.99)", fits with room to spare
+using TSensorText = TStaticString<32>;
+
+static_assert(AW_EVENT_STRING == 0 || AW_EVENT_STRING >= TSensorText::capacity(), "AW_EVENT_STRING would cut sensor messages");
+
 }
 
 #include "SensorMemory.h"
@@ -46,3 +52,4 @@ struct TEventSensorMessage : TBasicEvent<TEventSensorMessage> {
 #include "SensorAM2320.h"
 #include "SensorCT.h"
 #include "SensorCounter.h"
+#include "SensorActors.h"
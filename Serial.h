@@ -5,6 +5,12 @@
 
 namespace AW {
 
+// how long a 64 char receive buffer, the Arduino default, takes to fill
+// halfway at 10 bits a char. the serial actor polls the port that often
+constexpr TTime SerialPollPeriod(long baud) {
+    return TTime::MicroSeconds(32 * 10000000ull / baud);
+}
+
 template <HardwareSerial& Port, long Baud>
 class THardwareSerial {
 public:
@@ -12,6 +18,10 @@ public:
         Port.begin(Baud);
     }
 
+    static constexpr TTime PollPeriod() {
+        return SerialPollPeriod(Baud);
+    }
+
     int AvailableForRead() const {
         return Port.available();
     }
@@ -43,6 +53,10 @@ public:
         Port.begin(Baud);
     }
 
+    static constexpr TTime PollPeriod() {
+        return SerialPollPeriod(Baud);
+    }
+
     int AvailableForRead() const {
         return const_cast<SoftwareSerial&>(Port).available();
     }
@@ -62,45 +76,50 @@ public:
 
 
 struct TEventSerialData : TBasicEvent<TEventSerialData> {
-    constexpr static TEventID EventID = 2; // TODO
-    String Data;
+    constexpr static TEventID EventID = EventSerialData;
+    TEventString Data;
 
-    TEventSerialData(String data)
+    TEventSerialData(const TEventString& data)
         : Data(data) {}
 };
 
+// lines waiting for a slow port are dropped rather than piling up on the heap,
+// as many as the mailbox holds are written in one sweep
 template <typename SerialType>
-class TSerialActor : public TActor {
+class TSerialActor : public TActorHandlers<TSerialActor<SerialType>, TMailbox<8>, TEventBootstrap, TEventSerialData, TEventReceive> {
     static constexpr unsigned int MaxBufferSize = 256;
 public:
     TSerialActor(TActor* owner)
         : Owner(owner)
         , EOL("\n")
-    {}
+        , LongLines(0)
+    {
+        // the queued lines and the receive poll, which a full mailbox still takes
+        TActor::SetBudget(TActor::GetCapacity() + 1);
+    }
+
+    // received lines dropped for not fitting a TEventString
+    uint16_t GetLongLines() const { return LongLines; }
 
 protected:
     SerialType Port;
     TActor* Owner;
     String Buffer;
     StringBuf EOL;
+    uint16_t LongLines;
 
-    void OnEvent(TEventPtr event, const TActorContext& context) override {
-        switch (event->EventID) {
-        case TEventBootstrap::EventID:
-            return OnBootstrap(static_cast<TEventBootstrap*>(event.Release()), context);
-        case TEventSerialData::EventID:
-            return OnSerialData(static_cast<TEventSerialData*>(event.Release()), context);
-        case TEventReceive::EventID:
-            return OnReceive(static_cast<TEventReceive*>(event.Release()), context);
-        }
-    }
+    friend struct TEventHandlerAccess;
 
-    void OnBootstrap(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
         Port.Begin();
-        context.Send(this, this, new TEventReceive);
+        // the receive buffer of the port is small, drained ahead of other work
+        // and often enough not to overflow
+        TEventPtr receive = new TEventReceive;
+        receive->Priority = EPriority::High;
+        context.Send(this, this, receive);
     }
 
-    void OnSerialData(TUniquePtr<TEventSerialData> event, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventSerialData> event, const TActorContext& context) {
         int availableForWrite = Port.AvailableForWrite();
         int len = event->Data.length();
         int size = len > availableForWrite ? availableForWrite : len;
@@ -118,29 +137,28 @@ protected:
         }
     }
 
-    void OnReceive(TUniquePtr<TEventReceive> event, const TActorContext& context) {
+    void Handle(TUniquePtr<TEventReceive> event, const TActorContext& context) {
         auto size = min((unsigned int)Port.AvailableForRead(), MaxBufferSize - Buffer.size());
         if (size > 0) {
-            //::Serial.println(size);
-            int strStart = 0;
             auto bufferPos = Buffer.size();
-            Buffer.reserve(Buffer.size() + size);
-            size = Port.Read(Buffer.data() + Buffer.size(), size);
-            Buffer.resize(Buffer.size() + size);
-            while (bufferPos < Buffer.size()) {
-                if (Buffer[bufferPos] == '\n') {
-                    int strSize = bufferPos;
-                    while (strSize > 0 && Buffer[strSize - 1] == '\r') {
-                        --strSize;
-                    }
-                    //::Serial.println(Buffer.substr(strStart, strSize - strStart).data());
-                    context.Send(this, Owner, new TEventSerialData(Buffer.substr(strStart, strSize - strStart)));
-                    strStart = bufferPos + 1;
+            Buffer.reserve(bufferPos + size);
+            size = Port.Read(Buffer.data() + bufferPos, size);
+            Buffer.resize(bufferPos + size);
+            auto lines = SplitLines(Buffer, bufferPos, [&](StringBuf line) {
+#if AW_EVENT_STRING
+                // a cut line could pass for a whole one, it is not handed on
+                if (line.size() > TEventString::capacity()) {
+                    ++LongLines;
+                    return;
                 }
-                ++bufferPos;
-            }
-            Buffer = Buffer.substr(strStart, bufferPos - strStart);
+#endif
+                context.Call(this, Owner, new TEventSerialData(Buffer.substr(line.begin() - Buffer.begin(), line.size())));
+            });
+            // keeps the buffer block for the next read
+            Buffer.erase(0, lines);
         }
+        // a poll always due would keep the actor ready and the board awake
+        event->NotBefore = context.Now + Port.PollPeriod();
         context.Resend(this, event.Release());
     }
 };
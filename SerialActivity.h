@@ -29,24 +29,15 @@ public:
             int availableForRead = Port.AvailableForRead();
             int size = incomingSize > availableForRead ? availableForRead : incomingSize;
             if (size > 0) {
-                int strStart = 0;
                 int bufferPos = IncomingBufferSize;
                 size = Port.readBytes(&IncomingBuffer[IncomingBufferSize], size);
                 IncomingBufferSize += size;
-                while (bufferPos < IncomingBufferSize) {
-                    if (IncomingBuffer[bufferPos] == '\n') {
-                        int strSize = bufferPos;
-                        while (strSize > 0 && IncomingBuffer[strSize - 1] == '\r') {
-                            --strSize;
-                        }
-                        OnReceived(StringBuf(&IncomingBuffer[strStart], strSize));
-                        strStart = bufferPos + 1;
-                    }
-                    ++bufferPos;
-                }
-                IncomingBufferSize = bufferPos - strStart;
+                int lines = AW::SplitLines(AW::StringBuf(IncomingBuffer, IncomingBufferSize), bufferPos, [this](AW::StringBuf line) {
+                    OnReceived(line);
+                });
+                IncomingBufferSize -= lines;
                 if (IncomingBufferSize > 0) {
-                    memmove(IncomingBuffer, &IncomingBuffer[strStart], IncomingBufferSize);
+                    memmove(IncomingBuffer, &IncomingBuffer[lines], IncomingBufferSize);
                 }
             }
         }
@@ -36,11 +36,13 @@ public:
     }
 
     void write(double arg) {
-        write(String(arg));
+        write((float)arg);
     }
 
     void write(float arg) {
-        write(String(arg));
+        char buf[AW::FloatTextSize];
+        char* end = buf + sizeof(buf);
+        write(AW::StringBuf(AW::FormatFloat(end, arg, 2), end));
     }
 
     void write(AW::StringBuf arg) {
@@ -1,8 +1,72 @@
 #pragma once
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace AW {
 
+// the first c in [begin, end) a machine word at a time, end when there is none
+inline const char* FindCharWords(const char* begin, const char* end, char c) {
+    using TWord = uintptr_t;
+    constexpr TWord Ones = ~(TWord)0 / 0xff;
+    constexpr TWord Highs = Ones * 0x80;
+    while (begin != end && ((uintptr_t)begin & (sizeof(TWord) - 1)) != 0) {
+        if (*begin == c) {
+            return begin;
+        }
+        ++begin;
+    }
+    TWord pattern = Ones * (unsigned char)c;
+    while (end - begin >= (ptrdiff_t)sizeof(TWord)) {
+        TWord word;
+        memcpy(&word, begin, sizeof(word));
+        word ^= pattern;
+        // a zero byte in word is a match
+        if (((word - Ones) & ~word & Highs) != 0) {
+            break;
+        }
+        begin += sizeof(TWord);
+    }
+    while (begin != end && *begin != c) {
+        ++begin;
+    }
+    return begin;
+}
+
+#if defined(__SSE2__)
+inline const char* FindCharSSE2(const char* begin, const char* end, char c) {
+    __m128i pattern = _mm_set1_epi8(c);
+    while (end - begin >= 16) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)begin), pattern));
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+        begin += 16;
+    }
+    while (begin != end && *begin != c) {
+        ++begin;
+    }
+    return begin;
+}
+#endif
+
+// SSE2 on x86 hosts, the assembler memchr of avr-libc on AVR, word
+// compares on the 32-bit boards. lines of telemetry are too short for
+// wider vectors to pay off
+inline const char* FindChar(const char* begin, const char* end, char c) {
+#if defined(__SSE2__)
+    return FindCharSSE2(begin, end, c);
+#elif defined(__AVR__)
+    const char* found = (const char*)memchr(begin, c, end - begin);
+    return found != nullptr ? found : end;
+#else
+    return FindCharWords(begin, end, c);
+#endif
+}
+
 struct StringPointer {
     StringPointer(const char* ptr)
         : begin(ptr)
@@ -86,12 +150,8 @@ public:
     }
 
     size_type find(char c) const {
-        for (size_type p = 0; p < size(); ++p) {
-            if ((*this)[p] == c) {
-                return p;
-            }
-        }
-        return npos;
+        const char* found = FindChar(Begin, End, c);
+        return found != End ? found - Begin : npos;
     }
 
     operator int() const {
@@ -115,9 +175,133 @@ protected:
     const char* End;
 };
 
+// calls callback with every complete line of buffer, without its "\n" or
+// "\r\n", line ends are looked for from pos on. returns the size of the
+// lines passed, what follows them is an incomplete line
+template <typename Callback>
+StringBuf::size_type SplitLines(StringBuf buffer, StringBuf::size_type pos, Callback&& callback) {
+    const char* begin = buffer.begin();
+    const char* end = buffer.end();
+    const char* line = begin;
+    for (const char* eol = FindChar(begin + pos, end, '\n'); eol != end; eol = FindChar(eol + 1, end, '\n')) {
+        const char* lineEnd = eol;
+        while (lineEnd != line && lineEnd[-1] == '\r') {
+            --lineEnd;
+        }
+        callback(StringBuf(line, lineEnd));
+        line = eol + 1;
+    }
+    return line - begin;
+}
+
+// text of value / 10^decimals, written backwards so it ends at end,
+// returns where it begins
+template <typename UnsignedType>
+char* FormatScaled(char* end, UnsignedType value, uint8_t decimals) {
+    char* begin = end;
+    if (decimals != 0) {
+        do {
+            *--begin = '0' + value % 10;
+            value /= 10;
+        } while (--decimals != 0);
+        *--begin = '.';
+    }
+    do {
+        *--begin = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    return begin;
+}
+
+// value / 2^shift rounded half to even, like printf rounds
+template <typename UnsignedType>
+UnsignedType RoundShift(UnsignedType value, uint8_t shift) {
+    if (shift == 0) {
+        return value;
+    }
+    if (shift >= 8 * sizeof(UnsignedType)) {
+        return 0; // callers keep value below half of the type's range
+    }
+    UnsignedType result = value >> shift;
+    UnsignedType rest = value - (result << shift);
+    UnsignedType half = (UnsignedType)1 << (shift - 1);
+    if (rest > half || (rest == half && (result & 1) != 0)) {
+        ++result;
+    }
+    return result;
+}
+
+// room for a sign, ten integer digits, the point and nine decimals
+constexpr unsigned int FloatTextSize = 21;
+
+// the text printf("%.*f") gives for a float, from its bits with integer
+// arithmetic only: mantissa * 10^decimals is exact in 64 bits, so a single
+// rounded shift yields the scaled value. values of 2^32 and over print as
+// "ovf" like Arduino's Print, decimals are capped at nine
+inline char* FormatFloat(char* end, float value, uint8_t decimals) {
+    static const uint32_t Pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool negative = (bits >> 31) != 0;
+    int exponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+    char* begin = end;
+    if (exponent == 0xff || exponent >= 127 + 32) {
+        const char* text = exponent != 0xff ? "ovf" : mantissa != 0 ? "nan" : "inf";
+        begin -= 3;
+        memcpy(begin, text, 3);
+        if (exponent != 0xff || mantissa != 0) {
+            return begin;
+        }
+    } else {
+        if (decimals > 9) {
+            decimals = 9;
+        }
+        if (exponent == 0) {
+            exponent = 1; // subnormal
+        } else {
+            mantissa |= 0x800000;
+        }
+        // value = mantissa * 2^shift
+        int shift = exponent - 127 - 23;
+        if (decimals <= 2 && shift <= 0) {
+            // most sensor values, all in 32 bits
+            uint32_t scaled = RoundShift<uint32_t>(mantissa * Pow10[decimals], min(-shift, 32));
+            begin = FormatScaled(end, scaled, decimals);
+        } else {
+            uint64_t scaled = (uint64_t)mantissa * Pow10[decimals];
+            if (shift >= 0) {
+                scaled <<= shift;
+            } else {
+                scaled = RoundShift<uint64_t>(scaled, min(-shift, 64));
+            }
+            begin = FormatScaled(end, scaled, decimals);
+        }
+    }
+    if (negative) {
+        *--begin = '-';
+    }
+    return begin;
+}
+
+// a fixed-point integer for the streams, Value / 10^Decimals
+struct TFixed {
+    long Value;
+    uint8_t Decimals;
+
+    TFixed(long value, uint8_t decimals)
+        : Value(value)
+        , Decimals(decimals)
+    {}
+};
+
+// owning string: short contents live inline in the object, longer ones in a
+// ref-counted heap block shared by copies and substrings, literals are
+// referenced in place
 class String : public StringBuf {
 public:
     static constexpr size_type npos = 0xff;
+    static constexpr size_type InlineSize = AW_STRING_INLINE;
 
     constexpr String()
         : Buffer(nullptr)
@@ -182,54 +366,42 @@ public:
     String(float value, unsigned char decimalPlaces = 2)
         : String()
     {
-        char buf[33];
-        *this = StringPointer(dtostrf(value, (decimalPlaces + 2), decimalPlaces, buf));
+        char buf[FloatTextSize];
+        char* end = buf + sizeof(buf);
+        char* begin = FormatFloat(end, value, decimalPlaces);
+        assign(begin, end - begin);
     }
 
+    // formatted at float precision, all a sensor reading has
     String(double value, unsigned char decimalPlaces = 2)
-        : String()
-    {
-        char buf[33];
-        *this = StringPointer(dtostrf(value, (decimalPlaces + 2), decimalPlaces, buf));
-    }
+        : String((float)value, decimalPlaces)
+    {}
 
     String(const String& string)
-        : StringBuf(string.Begin, string.End)
+        : String()
     {
-        Buffer = string.Buffer;
-        if (Buffer != nullptr) {
-            ++Buffer->RefCounter;
-        }
+        Copy(string);
     }
 
-    String(String&& string) {
-        Buffer = string.Buffer;
-        Begin = string.Begin;
-        End = string.End;
-        string.Buffer = nullptr;
-        string.Begin = nullptr;
-        string.End = nullptr;
+    String(String&& string)
+        : String()
+    {
+        Move(string);
     }
 
     String& operator =(const String& string) {
-        Free();
-        Begin = string.Begin;
-        End = string.End;
-        Buffer = string.Buffer;
-        if (Buffer != nullptr) {
-            ++Buffer->RefCounter;
+        if (this != &string) {
+            Free();
+            Copy(string);
         }
         return *this;
     }
 
     String& operator =(String&& string) {
-        Free();
-        Buffer = string.Buffer;
-        Begin = string.Begin;
-        End = string.End;
-        string.Buffer = nullptr;
-        string.Begin = nullptr;
-        string.End = nullptr;
+        if (this != &string) {
+            Free();
+            Move(string);
+        }
         return *this;
     }
 
@@ -254,7 +426,7 @@ public:
 
     void assign(const char* string, size_type length) {
         resize(length);
-        memcpy(Buffer->Data, string, length);
+        memcpy(const_cast<char*>(Begin), string, length);
     }
 
     void append(const char* string, size_type length) {
@@ -273,10 +445,10 @@ public:
             String original = *this;
             resize(size() - length);
             if (pos != 0) {
-                memcpy(Buffer->Data, original.begin(), pos);
+                memcpy(const_cast<char*>(Begin), original.begin(), pos);
             }
             if (pos + length != original.size()) {
-                memcpy(Buffer->Data + pos, original.begin() + pos + length, original.size() - length - pos);
+                memcpy(const_cast<char*>(Begin) + pos, original.begin() + pos + length, original.size() - length - pos);
             }
         }
     }
@@ -303,35 +475,66 @@ public:
         return const_cast<char*>(Begin);
     }
 
-    bool _IsShared() const { return Buffer == nullptr || Buffer->RefCounter > 1; }
-    bool _IsUnique() const { return Buffer != nullptr && Buffer->RefCounter == 1; }
+    bool _IsInline() const { return IsInline(); }
+    bool _IsShared() const { return !IsInline() && (Buffer == nullptr || Buffer->RefCounter > 1); }
+    bool _IsUnique() const { return IsInline() || (Buffer != nullptr && Buffer->RefCounter == 1); }
 
 protected:
+    bool IsInline() const {
+        return (uintptr_t)Begin - (uintptr_t)Inline <= InlineSize;
+    }
+
+    // makes the string writable with room for size chars from Begin
     void EnsureOneOwner(size_type size = 0) {
-        if (Buffer != nullptr) {
-            if (Buffer->RefCounter != 1) {
-                StringBuf original = *this;
-                size = max((size_type)(16 - sizeof(StringData)), max(size, original.size()));
-                Free();
-                Alloc(size);
-                memcpy(Buffer->Data, original.data(), original.size());
-                End = Begin + original.size();
+        size_type length = this->size();
+        if (size < length) {
+            size = length;
+        }
+        if (IsInline()) {
+            if ((size_type)(Inline + InlineSize - Begin) >= size) {
+                return;
+            }
+            if (size <= InlineSize) {
+                memmove(Inline, Begin, length);
+                Begin = Inline;
             } else {
-                if (Begin == End && Begin != Buffer->Data) {
-                    End = Begin = Buffer->Data;
-                }
-                if ((size_type)(Buffer->Length) - (Begin - Buffer->Data) < size) {
-                    Realloc(max((size_type)(16 - sizeof(StringData)), max(size, this->size())));
-                }
+                // the whole inline buffer, its size is what bounds length
+                char original[InlineSize];
+                size_type offset = Begin - Inline;
+                memcpy(original, Inline, InlineSize);
+                // a string outgrowing its inline buffer is usually being
+                // built up, room for a few more appends saves a realloc
+                Alloc(max(size, (size_type)(2 * InlineSize)));
+                memcpy(Buffer->Data, original + offset, InlineSize - offset);
+            }
+        } else if (Buffer != nullptr && Buffer->RefCounter == 1) {
+            if ((size_type)(Buffer->Length) - (Begin - Buffer->Data) >= size) {
+                return;
+            }
+            memmove(Buffer->Data, Begin, length);
+            Begin = Buffer->Data;
+            End = Begin + length;
+            if (Buffer->Length < size) {
+                // grows by half at least, so appends stay amortized
+                Realloc(max(size, (size_type)(Buffer->Length + Buffer->Length / 2)));
             }
         } else {
-            if (size != 0) {
-                StringBuf original = *this;
+            if (size == 0) {
+                return;
+            }
+            StringBuf original = *this;
+            StringData* shared = Buffer;
+            if (size <= InlineSize) {
+                Begin = Inline;
+            } else {
                 Alloc(size);
-                memcpy(Buffer->Data, original.data(), original.size());
-                End = Begin + original.size();
             }
+            if (length != 0) {
+                memcpy(const_cast<char*>(Begin), original.data(), length);
+            }
+            Release(shared);
         }
+        End = Begin + length;
     }
 
     String(const String& string, size_type pos, size_type length)
@@ -341,11 +544,17 @@ protected:
             length = pos > size ? 0 : size - pos;
         }
         if (length != 0) {
-            Buffer = string.Buffer;
-            if (Buffer != nullptr) {
-                ++Buffer->RefCounter;
+            // short pieces are copied, so they do not pin a large buffer
+            if (string.IsInline() || (string.Buffer != nullptr && length <= InlineSize)) {
+                memcpy(Inline, string.Begin + pos, length);
+                Begin = Inline;
+            } else {
+                Buffer = string.Buffer;
+                if (Buffer != nullptr) {
+                    ++Buffer->RefCounter;
+                }
+                Begin = string.Begin + min(pos, size);
             }
-            Begin = string.Begin + min(pos, size);
             End = Begin + length;
         }
     }
@@ -362,7 +571,36 @@ protected:
 #pragma warning(default:4200)
 #endif
 
+    void Copy(const String& string) {
+        if (string.IsInline()) {
+            memcpy(Inline, string.Inline, InlineSize);
+            Begin = Inline + (string.Begin - string.Inline);
+            End = Inline + (string.End - string.Inline);
+        } else {
+            Buffer = string.Buffer;
+            if (Buffer != nullptr) {
+                ++Buffer->RefCounter;
+            }
+            Begin = string.Begin;
+            End = string.End;
+        }
+    }
+
+    // a heap block changes hands with its reference, only inline text is copied
+    void Move(String& string) {
+        if (string.IsInline()) {
+            Copy(string);
+        } else {
+            Buffer = string.Buffer;
+            Begin = string.Begin;
+            End = string.End;
+        }
+        string.Buffer = nullptr;
+        string.Begin = string.End = nullptr;
+    }
+
     void Alloc(size_type length) {
+        length = max(length, (size_type)(16 - sizeof(StringData)));
         Buffer = (StringData*)malloc(length + sizeof(StringData));
         Buffer->Length = length;
         Buffer->RefCounter = 1;
@@ -370,84 +608,127 @@ protected:
         End = Begin;
     }
 
+    static void Release(StringData* buffer) {
+        if (buffer != nullptr && --buffer->RefCounter == 0) {
+            free(buffer);
+        }
+    }
+
     void Free() {
-        if (Buffer != nullptr) {
-            if (--Buffer->RefCounter == 0) {
-                free(Buffer);
-                Buffer = nullptr;
-                Begin = End = nullptr;
-            }
+        if (!IsInline()) {
+            Release(Buffer);
         }
+        Buffer = nullptr;
+        Begin = End = nullptr;
     }
 
+    // the contents start at Data
     void Realloc(size_type length) {
-        StringData* newBuffer = (StringData*)realloc(Buffer, length + sizeof(StringData));
-        if (newBuffer == Buffer) {
-            Buffer->Length = length;
-        } else {
-            size_type size = this->size();
-            Buffer = newBuffer;
-            Buffer->RefCounter = 1;
-            Buffer->Length = length;
-            Begin = Buffer->Data;
-            End = Begin + size;
-        }
+        size_type size = this->size();
+        Buffer = (StringData*)realloc(Buffer, length + sizeof(StringData));
+        Buffer->Length = length;
+        Begin = Buffer->Data;
+        End = Begin + size;
     }
 
-    StringData* Buffer;
+    // a string is inline while Begin points into Inline, Buffer is only
+    // valid otherwise
+    union {
+        StringData* Buffer;
+        char Inline[InlineSize];
+    };
 };
 
-class StringStream {
+// number formatting shared by the string builders, Type provides append()
+template <typename Type>
+class TStringFormat {
 public:
-    /*StringStream& operator <<(String string) {
-        Data += string;
-        return *this;
-    }*/
+    Type& operator <<(StringBuf string) {
+        Self().append(string.data(), string.size());
+        return Self();
+    }
 
-    StringStream& operator <<(StringBuf string) {
-        Data += string;
-        return *this;
+    Type& operator <<(char string) {
+        Self().append(&string, 1);
+        return Self();
     }
 
-    StringStream& operator <<(char string) {
-        Data += string;
-        return *this;
+    Type& operator <<(int value) {
+        return AppendSigned<unsigned int>(value);
     }
 
-    StringStream& operator <<(int string) {
-        Data += String(string);
-        return *this;
+    Type& operator <<(unsigned int value) {
+        return AppendUnsigned(value, false);
     }
 
-    StringStream& operator <<(unsigned int string) {
-        Data += String(string);
-        return *this;
+    Type& operator <<(long value) {
+        return AppendSigned<unsigned long>(value);
     }
 
-    StringStream& operator <<(long string) {
-        Data += String(string);
-        return *this;
+    Type& operator <<(unsigned long value) {
+        return AppendUnsigned(value, false);
     }
 
-    StringStream& operator <<(unsigned long string) {
-        Data += String(string);
-        return *this;
+    Type& operator <<(float value) {
+        char buf[FloatTextSize];
+        char* end = buf + sizeof(buf);
+        char* begin = FormatFloat(end, value, 2);
+        Self().append(begin, end - begin);
+        return Self();
     }
 
-    StringStream& operator <<(float string) {
-        Data += String(string);
-        return *this;
+    Type& operator <<(double value) {
+        return *this << (float)value;
     }
 
-    StringStream& operator <<(double string) {
-        Data += String(string);
-        return *this;
+    Type& operator <<(TFixed value) {
+        char buf[2 + 3 * sizeof(long)];
+        char* end = buf + sizeof(buf);
+        unsigned long magnitude = value.Value < 0 ? 0 - (unsigned long)value.Value : value.Value;
+        char* begin = FormatScaled(end, magnitude, min(value.Decimals, (uint8_t)(3 * sizeof(long) - 1)));
+        if (value.Value < 0) {
+            *--begin = '-';
+        }
+        Self().append(begin, end - begin);
+        return Self();
+    }
+
+protected:
+    Type& Self() {
+        return static_cast<Type&>(*this);
     }
 
+    template <typename UnsignedType, typename ValueType>
+    Type& AppendSigned(ValueType value) {
+        if (value < 0) {
+            return AppendUnsigned(0 - (UnsignedType)value, true);
+        }
+        return AppendUnsigned((UnsignedType)value, false);
+    }
+
+    // digits are collected backwards on the stack and appended in one go
+    template <typename ValueType>
+    Type& AppendUnsigned(ValueType value, bool negative) {
+        char buf[1 + 3 * sizeof(ValueType)];
+        char* begin = FormatScaled(buf + sizeof(buf), value, 0);
+        if (negative) {
+            *--begin = '-';
+        }
+        Self().append(begin, buf + sizeof(buf) - begin);
+        return Self();
+    }
+};
+
+class StringStream : public TStringFormat<StringStream> {
+public:
     operator String() const {
         return Data;
     }
 
+    void append(const char* string, String::size_type length) {
+        Data.append(string, length);
+    }
+
     void clear() {
         Data.clear();
     }
@@ -456,8 +737,129 @@ public:
         return Data.size();
     }
 
+    // room for a whole line up front, so appends do not grow the buffer
+    void reserve(String::size_type size) {
+        Data.reserve(size);
+    }
+
 protected:
     String Data;
 };
 
+// string of at most N chars kept in the object, it never allocates and cuts
+// whatever does not fit, which truncated() reports
+template <unsigned int N>
+class TStaticString : public StringBuf, public TStringFormat<TStaticString<N>> {
+public:
+    TStaticString()
+        : StringBuf(Storage, Storage)
+        , Truncated(false)
+    {}
+
+    TStaticString(const char* begin, size_type length)
+        : TStaticString()
+    {
+        append(begin, length);
+    }
+
+    template <size_type M>
+    TStaticString(const char(&string)[M])
+        : TStaticString(string, M - 1)
+    {}
+
+    TStaticString(StringBuf string)
+        : TStaticString(string.data(), string.size())
+    {}
+
+    TStaticString(const TStaticString& string)
+        : TStaticString(string.data(), string.size())
+    {
+        Truncated = string.Truncated;
+    }
+
+    TStaticString& operator =(const TStaticString& string) {
+        if (this != &string) {
+            assign(string.data(), string.size());
+            Truncated = string.Truncated;
+        }
+        return *this;
+    }
+
+    TStaticString& operator +=(const StringBuf& string) {
+        append(string.data(), string.size());
+        return *this;
+    }
+
+    TStaticString& operator +=(char string) {
+        append(&string, 1);
+        return *this;
+    }
+
+    void assign(const char* string, size_type length) {
+        clear();
+        if (length > N) {
+            length = N;
+            Truncated = true;
+        }
+        // the source may be a piece of this string
+        memmove(Storage, string, length);
+        End = Begin + length;
+    }
+
+    void append(const char* string, size_type length) {
+        size_type room = N - size();
+        if (length > room) {
+            length = room;
+            Truncated = true;
+        }
+        memcpy(Storage + size(), string, length);
+        End += length;
+    }
+
+    void erase(size_type pos, size_type length) {
+        size_type size = this->size();
+        if (pos >= size) {
+            return;
+        }
+        if (length > size - pos) {
+            length = size - pos;
+        }
+        memmove(Storage + pos, Storage + pos + length, size - pos - length);
+        End -= length;
+    }
+
+    void resize(size_type length) {
+        if (length > N) {
+            length = N;
+            Truncated = true;
+        }
+        End = Begin + length;
+    }
+
+    void clear() {
+        End = Begin;
+        Truncated = false;
+    }
+
+    char* data() {
+        return Storage;
+    }
+
+    const char* data() const {
+        return Storage;
+    }
+
+    static constexpr size_type capacity() {
+        return N;
+    }
+
+    bool truncated() const {
+        return Truncated;
+    }
+
+protected:
+    char Storage[N];
+    bool Truncated;
+};
+
 }
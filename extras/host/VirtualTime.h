@@ -0,0 +1,28 @@
+#pragma once
+
+#include <ArduinoWorkflow.h>
+#include <Host.h>
+
+// Deterministic time for host runs. With the simulated clock on, time moves
+// only when a handler calls delay() or when the runtime has nothing ready and
+// asks to sleep; then the clock jumps straight to the next NotBefore. Hours of
+// timers take as long as their handlers, and the same sketch replays the same
+// schedule every time.
+//
+//     Host::UseSimulatedClock(true);
+//     TVirtualIdle idle;
+//     lib.SetIdle(&idle);
+//     while (millis() < end) lib.Run();
+class TVirtualIdle : public AW::TIdle {
+public:
+    unsigned long Jumps = 0;
+
+    void Sleep(AW::TTime duration) override {
+        // nothing is scheduled at all, the clock would only wrap around
+        if (duration == AW::TTime::Max()) {
+            return;
+        }
+        ++Jumps;
+        Host::AdvanceClock(duration.MicroSeconds());
+    }
+};
@@ -0,0 +1,1359 @@
+// host benchmark of the actor runtime, see extras/host/Makefile
+#include <ArduinoWorkflow.h>
+#include <Host.h>
+#include "Check.h"
+#include "VirtualTime.h"
+
+#include <algorithm>
+#include <new>
+#include <stdio.h>
+#include <vector>
+
+using namespace AW;
+
+namespace {
+
+unsigned long HeapAllocations = 0;
+unsigned long MallocCalls = 0;
+
+}
+
+// AW::String allocates with malloc, counted here through the glibc entry points
+#ifndef __SANITIZE_ADDRESS__
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+extern "C" void* malloc(size_t size) {
+    ++MallocCalls;
+    return __libc_malloc(size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    ++MallocCalls;
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+void* operator new(size_t size) {
+    ++HeapAllocations;
+    void* ptr = malloc(size != 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+
+struct TEventPing : TBasicEvent<TEventPing> {
+    constexpr static TEventID EventID = EventUser;
+    uint64_t Sent;
+    unsigned long Sequence;
+
+    TEventPing(unsigned long sequence)
+        : Sent(Host::Nanos())
+        , Sequence(sequence)
+    {}
+};
+
+struct TMeasure {
+    uint64_t Start;
+    unsigned long Allocations;
+
+    TMeasure()
+        : Start(Host::Nanos())
+        , Allocations(HeapAllocations)
+    {}
+
+    double Seconds() const {
+        return (Host::Nanos() - Start) / 1e9;
+    }
+
+    unsigned long Allocated() const {
+        return HeapAllocations - Allocations;
+    }
+};
+
+struct TLatencies {
+    std::vector<uint32_t> Values;
+
+    void Report() {
+        std::sort(Values.begin(), Values.end());
+        auto percentile = [this](double p) { return Values[(size_t)(p * (Values.size() - 1))]; };
+        printf("  latency ns: p50 %u p90 %u p99 %u p99.9 %u max %u\n",
+            percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999), Values.back());
+    }
+};
+
+// two actors bouncing fresh events to each other, every event is allocated,
+// sent, dispatched and freed once
+class TPingPong : public TActorHandlers<TPingPong, TEventPing> {
+public:
+    TPingPong* Peer = nullptr;
+    TLatencies* Latencies = nullptr;
+    unsigned long Limit = 0;
+    unsigned long Handled = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventPing> event, const TActorContext& context) {
+        Latencies->Values.push_back(Host::Nanos() - event->Sent);
+        ++Handled;
+        if (event->Sequence < Limit) {
+            context.Send(this, Peer, new TEventPing(event->Sequence + 1));
+        }
+    }
+};
+
+void BenchPingPong(unsigned long inFlight) {
+    const unsigned long total = 1000000;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TPingPong ping;
+    TPingPong pong;
+    TLatencies latencies;
+    latencies.Values.reserve(total + inFlight);
+    ping.Peer = &pong;
+    pong.Peer = &ping;
+    ping.Latencies = pong.Latencies = &latencies;
+    ping.Limit = pong.Limit = total / inFlight;
+    lib.Register(&ping);
+    lib.Register(&pong);
+    lib.Run();
+
+    TMeasure measure;
+    for (unsigned long i = 0; i < inFlight; ++i) {
+        lib.Send(nullptr, &ping, new TEventPing(1));
+    }
+    unsigned long runs = 0;
+    while (ping.Handled + pong.Handled < inFlight * ping.Limit) {
+        lib.Run();
+        ++runs;
+    }
+    double seconds = measure.Seconds();
+    unsigned long events = ping.Handled + pong.Handled;
+    CHECK(events == inFlight * ping.Limit);
+
+    printf("ping-pong, %lu in flight\n", inFlight);
+    printf("  %lu events in %.3f s: %.0f events/s, %.2f events/run, %.3f heap allocations/event\n",
+        events, seconds, events / seconds, (double)events / runs, (double)measure.Allocated() / events);
+    latencies.Report();
+}
+
+// the same ping-pong with both actors in a TArduinoWorkflow, dispatched
+// without the virtual OnEvent call
+void BenchStaticDispatch() {
+    const unsigned long total = 1000000;
+    Host::UseSimulatedClock(true);
+    TArduinoWorkflow<TPingPong, TPingPong> workflow;
+    TPingPong& ping = workflow.Get<0>();
+    TPingPong& pong = workflow.Get<1>();
+    TLatencies latencies;
+    latencies.Values.reserve(total + 1);
+    ping.Peer = &pong;
+    pong.Peer = &ping;
+    ping.Latencies = pong.Latencies = &latencies;
+    ping.Limit = pong.Limit = total;
+    workflow.Begin();
+    workflow.Run();
+
+    TMeasure measure;
+    workflow.Send(nullptr, &ping, new TEventPing(1));
+    unsigned long runs = 0;
+    while (ping.Handled + pong.Handled < total) {
+        workflow.Run();
+        ++runs;
+    }
+    double seconds = measure.Seconds();
+    unsigned long events = ping.Handled + pong.Handled;
+    CHECK(events == total);
+
+    printf("ping-pong, static workflow\n");
+    printf("  %lu events in %.3f s: %.0f events/s, %.2f events/run, %.3f heap allocations/event\n",
+        events, seconds, events / seconds, (double)events / runs, (double)measure.Allocated() / events);
+    latencies.Report();
+}
+
+class TOwner : public TActor {
+public:
+    unsigned long SensorData = 0;
+    unsigned long Other = 0;
+
+    void OnEvent(TEventPtr event, const TActorContext&) override {
+        if (event->EventID == EventSensorData) {
+            ++SensorData;
+        } else {
+            ++Other;
+        }
+    }
+};
+
+// one hop of a request passing through several actors, like Bluetooth -> Serial -> Owner
+class TRelay : public TActorHandlers<TRelay, TEventPing> {
+public:
+    TActor* Next = nullptr;
+    bool UseCall = false;
+    unsigned long Handled = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventPing> event, const TActorContext& context) {
+        ++Handled;
+        if (Next != nullptr) {
+            if (UseCall) {
+                context.Call(this, Next, event.Release());
+            } else {
+                context.Send(this, Next, event.Release());
+            }
+        }
+    }
+};
+
+void BenchChain(bool call) {
+    const unsigned long chains = 300000;
+    const int length = AW_CALL_DEPTH + 2;
+    TActorLib lib;
+    TRelay relays[length];
+    for (int i = 0; i < length; ++i) {
+        relays[i].Next = i + 1 < length ? &relays[i + 1] : nullptr;
+        relays[i].UseCall = call;
+        lib.Register(&relays[i]);
+    }
+    lib.Run();
+
+    TMeasure measure;
+    unsigned long runs = 0;
+    for (unsigned long i = 0; i < chains; ++i) {
+        lib.Send(nullptr, &relays[0], new TEventPing(0));
+        while (relays[length - 1].Handled == i) {
+            lib.Run();
+            ++runs;
+        }
+    }
+    double seconds = measure.Seconds();
+    // calls nest up to AW_CALL_DEPTH deep, the rest of the chain waits for the next run
+    CHECK(runs == chains * (call ? 2 : length));
+
+    printf("chain of %d actors, %s\n", length, call ? "call" : "send");
+    printf("  %lu chains in %.3f s: %.0f chains/s, %.1f runs/chain\n",
+        chains, seconds, chains / seconds, (double)runs / chains);
+}
+
+// a chatty actor with a backlog, about a microsecond of work per event
+class TBusySink : public TActorHandlers<TBusySink, TEventPing> {
+public:
+    unsigned long Handled = 0;
+    uint32_t Hash = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventPing> event, const TActorContext&) {
+        uint32_t hash = Hash ^ event->Sequence;
+        for (int i = 0; i < 200; ++i) {
+            hash = hash * 16777619u ^ i;
+        }
+        Hash = hash;
+        ++Handled;
+    }
+};
+
+// the sink kept 64 events behind, next to a ping-pong pair timing its turns,
+// on the wall clock for the time budget
+void BenchBudget(uint8_t budget, uint16_t micros) {
+    const unsigned long sweeps = 200000;
+    const unsigned long backlog = 64;
+    TActorLib lib;
+    TBusySink sink;
+    TPingPong ping;
+    TPingPong pong;
+    TLatencies latencies;
+    latencies.Values.reserve(2 * sweeps);
+    sink.SetBudget(budget, micros);
+    ping.Peer = &pong;
+    pong.Peer = &ping;
+    ping.Latencies = pong.Latencies = &latencies;
+    ping.Limit = pong.Limit = ~0ul;
+    lib.Register(&sink);
+    lib.Register(&ping);
+    lib.Register(&pong);
+    lib.Run();
+
+    TMeasure measure;
+    unsigned long sent = 0;
+    lib.Send(nullptr, &ping, new TEventPing(1));
+    for (unsigned long i = 0; i < sweeps; ++i) {
+        while (sent - sink.Handled < backlog) {
+            lib.Send(nullptr, &sink, new TEventPing(sent++));
+        }
+        lib.Run();
+    }
+    double seconds = measure.Seconds();
+    CHECK(sink.Handled > 0);
+
+    printf("budget %u events%s", budget, micros != 0 ? "" : "\n");
+    if (micros != 0) {
+        printf(" or %u us\n", micros);
+    }
+    printf("  sink %.0f events/s, %.1f events/sweep\n", sink.Handled / seconds, (double)sink.Handled / sweeps);
+    latencies.Report();
+}
+
+// telemetry forwarder writing sensor values to the serial port, one write
+// per value or one write per batch
+class TForwarder : public TActorHandlers<TForwarder, TEventSensorData> {
+public:
+    unsigned long Values = 0;
+    unsigned long Writes = 0;
+
+    TForwarder(bool batched) {
+        SetBatched(batched);
+        SetBudget(32);
+    }
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    static void Format(StringStream& stream, const TEventSensorData& event) {
+        stream << event.Source.Name << '.' << event.Value.Name << '=' << (long)event.Value.Value << '\n';
+    }
+
+    void Write(AW::String data) {
+        Serial.write(data.data(), data.size());
+        ++Writes;
+    }
+
+    void Handle(TUniquePtr<TEventSensorData> event, const TActorContext&) {
+        StringStream stream;
+        Format(stream, *event);
+        Write(stream);
+        ++Values;
+    }
+
+    void OnEventBatch(TEventBatch& batch, const TActorContext&) override {
+        StringStream stream;
+        for (auto itEvent = batch.begin(); itEvent != batch.end(); ++itEvent) {
+            if (itEvent.Get()->EventID == TEventSensorData::EventID) {
+                Format(stream, *static_cast<TEventSensorData*>(itEvent.Get()));
+                ++Values;
+            }
+        }
+        if (stream.size() != 0) {
+            Write(stream);
+        }
+    }
+};
+
+// 30 sensor values per period, the telemetry of a full board
+void BenchBatch(bool batched) {
+    const unsigned long periods = 20000;
+    TActorLib lib;
+    TForwarder forwarder(batched);
+    TSensor<3> sensors[10];
+    for (TSensor<3>& sensor : sensors) {
+        sensor.Name = "sensor";
+        sensor.Values[0].Name = "temperature";
+        sensor.Values[1].Name = "humidity";
+        sensor.Values[2].Name = "pressure";
+    }
+    lib.Register(&forwarder);
+    lib.Run();
+
+    TMeasure measure;
+    for (unsigned long i = 0; i < periods; ++i) {
+        for (TSensor<3>& sensor : sensors) {
+            for (TSensorValue& value : sensor.Values) {
+                value.Value = i;
+                lib.Send(nullptr, &forwarder, new TEventSensorData(sensor, value));
+            }
+        }
+        lib.Run();
+        Serial.ClearOutput();
+    }
+    double seconds = measure.Seconds();
+    CHECK(forwarder.Values == periods * 30);
+    CHECK(forwarder.Writes == (batched ? periods : periods * 30));
+
+    printf("forwarder, 30 sensor values per period, %s\n", batched ? "batched" : "one by one");
+    printf("  %lu values in %.3f s: %.0f values/s, %lu port writes\n",
+        forwarder.Values, seconds, forwarder.Values / seconds, forwarder.Writes);
+}
+
+// answers every line read by the serial actor with the same line
+class TEcho : public TActorHandlers<TEcho, TEventSerialData> {
+public:
+    TActor* Port = nullptr;
+    unsigned long Lines = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventSerialData> event, const TActorContext& context) {
+        ++Lines;
+        context.Send(this, Port, new TEventSerialData(event->Data));
+    }
+};
+
+// a line in through TSerialActor, to the owner and back out to the port
+void BenchSerialData(const char* line) {
+    const unsigned long rounds = 100000;
+    const unsigned long lines = 3;
+    // the port is polled once per poll period, slept through in between
+    Host::UseSimulatedClock(true);
+    TVirtualIdle idle;
+    TActorLib lib;
+    lib.SetIdle(&idle);
+    TEcho echo;
+    TSerialActor<THardwareSerial<Serial, 115200>> serial(&echo);
+    echo.Port = &serial;
+    lib.Register(&echo);
+    lib.Register(&serial);
+    lib.Run();
+    Serial.ClearOutput();
+    size_t length = strlen(line);
+    Serial.WriteWindow = 1024;
+
+    TMeasure measure;
+    unsigned long mallocs = MallocCalls;
+    for (unsigned long i = 0; i < rounds; ++i) {
+        for (unsigned long j = 0; j < lines; ++j) {
+            Serial.Feed(line, length);
+        }
+        lib.Run();
+        lib.Run();
+    }
+    double seconds = measure.Seconds();
+    mallocs = MallocCalls - mallocs;
+    Serial.WriteWindow = 64;
+    Host::UseSimulatedClock(false);
+    CHECK(echo.Lines == rounds * lines);
+    CHECK(Serial.OutputSize == rounds * lines * length);
+    Serial.ClearOutput();
+
+    printf("serial data round trip, %u chars per line\n", (unsigned)length - 1);
+    printf("  %lu lines in %.3f s: %.0f ns/line, %.2f mallocs/line\n",
+        echo.Lines, seconds, seconds * 1e9 / echo.Lines, (double)mallocs / echo.Lines);
+}
+
+// the diagnostic line of the INA219 sensor
+template <typename StreamType>
+void BenchFormat(const char* name) {
+    const unsigned long lines = 1000000;
+    unsigned long size = 0;
+
+    TMeasure measure;
+    unsigned long mallocs = MallocCalls;
+    for (unsigned long i = 0; i < lines; ++i) {
+        uint16_t busVoltage = 0x1a2b + i % 16;
+        float busValue = 12.34f + i % 16;
+        StreamType stream;
+        stream << "bus " << AW::String(busVoltage, 16) << " (" << busValue << ")";
+        size += stream.size();
+    }
+    double seconds = measure.Seconds();
+    mallocs = MallocCalls - mallocs;
+    CHECK(mallocs <= lines);
+    CHECK(size == lines * 16);
+
+    printf("%s formatting, \"bus 1a2b (12.34)\"\n", name);
+    printf("  %lu lines in %.3f s: %.0f ns/line, %.2f mallocs/line\n",
+        lines, seconds, seconds * 1e9 / lines, (double)mallocs / lines);
+}
+
+// the three BME280 values of a period
+void BenchFormatFloat() {
+    const unsigned long periods = 1000000;
+    float values[3] = { 21.37f, 45.12f, 749.65f };
+    unsigned long size = 0;
+
+    TMeasure measure;
+    for (unsigned long i = 0; i < periods; ++i) {
+        for (float value : values) {
+            char buf[FloatTextSize];
+            char* end = buf + sizeof(buf);
+            size += end - FormatFloat(end, value + i % 16, 2);
+        }
+    }
+    double seconds = measure.Seconds();
+
+    TMeasure reference;
+    for (unsigned long i = 0; i < periods; ++i) {
+        for (float value : values) {
+            char buf[33];
+            size -= strlen(dtostrf(value + i % 16, 4, 2, buf));
+        }
+    }
+    double referenceSeconds = reference.Seconds();
+    CHECK(size == 0);
+
+    printf("float formatting, 3 values with 2 decimals\n");
+    printf("  %.0f ns/value, dtostrf %.0f ns/value\n",
+        seconds * 1e9 / periods / 3, referenceSeconds * 1e9 / periods / 3);
+}
+
+const char* FindCharBytes(const char* begin, const char* end, char c) {
+    while (begin != end && *begin != c) {
+        ++begin;
+    }
+    return begin;
+}
+
+const char* FindCharMemchr(const char* begin, const char* end, char c) {
+    const char* found = (const char*)memchr(begin, c, end - begin);
+    return found != nullptr ? found : end;
+}
+
+// a long line handed on by move, as events and queues do
+void BenchStringMove() {
+    const unsigned long moves = 1000000;
+    AW::String line;
+    line += "sensor.temperature=21.5 sensor.humidity=40";
+    CHECK(line._IsUnique());
+
+    TMeasure measure;
+    unsigned long mallocs = MallocCalls;
+    for (unsigned long i = 0; i < moves; ++i) {
+        AW::String moved(std::move(line));
+        CHECK(line.empty());
+        line = std::move(moved);
+        CHECK(moved.empty());
+    }
+    double seconds = measure.Seconds();
+    mallocs = MallocCalls - mallocs;
+    CHECK(mallocs == 0);
+    // a moved string is still the only owner, appends need no copy
+    CHECK(line._IsUnique());
+
+    printf("string move, %u chars\n", (unsigned)line.size());
+    printf("  %lu moves in %.3f s: %.1f ns/move\n", moves, seconds, seconds * 1e9 / moves);
+}
+
+// line splitting of a gateway, telemetry lines of many nodes in 4 KB reads
+void BenchSplitLines() {
+    std::vector<char> input;
+    unsigned long expected = 0;
+    uint32_t seed = 1;
+    while (input.size() < 4096 - 80) {
+        seed = seed * 1664525 + 1013904223;
+        char line[80];
+        int size = snprintf(line, sizeof(line), "node%u.sensor%u.temperature=%u.%02u%s",
+            seed % 64, (seed >> 8) % 8, (seed >> 12) % 40, (seed >> 16) % 100, (seed >> 20) % 2 != 0 ? "\r\n" : "\n");
+        input.insert(input.end(), line, line + size);
+        ++expected;
+    }
+    StringBuf chunk(input.data(), input.size());
+
+    // every splitter sees the same lines at all alignments
+    for (unsigned int offset = 0; offset < 64; ++offset) {
+        unsigned long lines = 0;
+        unsigned long size = SplitLines(chunk.substr(offset, chunk.size()), 0, [&](StringBuf line) {
+            CHECK(line.find('\n') == StringBuf::npos && (line.size() == 0 || line[line.size() - 1] != '\r'));
+            ++lines;
+        });
+        CHECK(lines == (unsigned long)std::count(input.begin() + offset, input.end(), '\n'));
+        CHECK(size == chunk.size() - offset);
+        for (auto find : { FindCharBytes, FindCharMemchr, FindCharWords }) {
+            CHECK(find(chunk.begin() + offset, chunk.end(), '\n') == FindChar(chunk.begin() + offset, chunk.end(), '\n'));
+            CHECK(find(chunk.begin() + offset, chunk.begin() + offset + 8, '=') == FindCharBytes(chunk.begin() + offset, chunk.begin() + offset + 8, '='));
+        }
+    }
+
+    auto run = [&](const char* name, const char* (*find)(const char*, const char*, char)) {
+        const unsigned long rounds = 20000;
+        unsigned long lines = 0;
+        TMeasure measure;
+        for (unsigned long i = 0; i < rounds; ++i) {
+            const char* begin = chunk.begin();
+            const char* end = chunk.end();
+            for (const char* eol = find(begin, end, '\n'); eol != end; eol = find(eol + 1, end, '\n')) {
+                ++lines;
+            }
+        }
+        double seconds = measure.Seconds();
+        CHECK(lines == expected * rounds);
+        printf("  %-7s %.0f MB/s\n", name, chunk.size() * rounds / seconds / 1e6);
+    };
+    printf("line splitting, %lu lines in %u bytes\n", expected, chunk.size());
+    run("bytes", FindCharBytes);
+    run("memchr", FindCharMemchr);
+    run("words", FindCharWords);
+#if defined(__SSE2__)
+    run("sse2", FindCharSSE2);
+#endif
+}
+
+template <EOverflow Policy>
+class TBoundedSink : public TActorHandlers<TBoundedSink<Policy>, TMailbox<4, Policy>, TEventPing> {
+public:
+    std::vector<unsigned long> Seen;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventPing> event, const TActorContext&) {
+        Seen.push_back(event->Sequence);
+    }
+};
+
+// a 1 ms timer in a mailbox of two, flooded by a peer
+template <EOverflow Policy>
+class TFloodedTicker : public TActorHandlers<TFloodedTicker<Policy>, TMailbox<2, Policy>, TEventBootstrap, TEventPing> {
+public:
+    TTimer Timer;
+    unsigned long Ticks = 0;
+
+    TFloodedTicker() {
+        TActor::SetBudget(1);
+    }
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        context.Start(Timer, this, TTime::MilliSeconds(1));
+    }
+
+    void Handle(TUniquePtr<TEventPing>, const TActorContext&) {}
+
+    void OnTimer(TTimer&, const TActorContext&) override {
+        ++Ticks;
+    }
+};
+
+// the ticker's own timer survives the flood whatever the policy
+template <EOverflow Policy>
+void BenchOverflowTimer() {
+    const unsigned long millis = 50;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TFloodedTicker<Policy> ticker;
+    lib.Register(&ticker);
+    lib.Run();
+    for (unsigned long i = 0; i < millis * 10; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            lib.Send(nullptr, &ticker, new TEventPing(i));
+        }
+        lib.Run();
+        Host::AdvanceClock(100);
+    }
+    Host::UseSimulatedClock(false);
+    CHECK(ticker.Timer.Pending());
+    CHECK(ticker.Ticks >= millis - 2);
+    CHECK(ticker.GetDropped() > 0);
+}
+
+// ten events into a mailbox of four
+template <EOverflow Policy>
+void BenchOverflow(const char* name, std::vector<unsigned long> expected) {
+    TActorLib lib;
+    TBoundedSink<Policy> sink;
+    lib.Register(&sink);
+    lib.Run();
+    unsigned long allocations = HeapAllocations;
+    for (unsigned long i = 0; i < 10; ++i) {
+        lib.Send(nullptr, &sink, new TEventPing(i));
+    }
+    lib.Run();
+    CHECK(sink.Seen == expected);
+    CHECK(sink.GetDropped() == 6);
+
+    printf("mailbox of 4, %s: %lu delivered, %u dropped, %lu heap allocations\n",
+        name, (unsigned long)sink.Seen.size(), sink.GetDropped(), HeapAllocations - allocations);
+    BenchOverflowTimer<Policy>();
+}
+
+struct TDiagnosticsEnvironment : TDefaultEnvironment {
+    static constexpr bool Diagnostics = true;
+};
+
+// the same traffic with per-actor counters collected
+void BenchDiagnostics() {
+    const unsigned long total = 1000000;
+    TActorLib lib;
+    TPingPong ping;
+    TPingPong pong;
+    TOwner owner;
+    TSensorActors<2, TDiagnosticsEnvironment> sensor(&owner);
+    TLatencies latencies;
+    latencies.Values.reserve(total + 1);
+    ping.Peer = &pong;
+    pong.Peer = &ping;
+    ping.Latencies = pong.Latencies = &latencies;
+    ping.Limit = pong.Limit = total;
+    sensor.Period = TTime::MilliSeconds(1000000);
+    sensor.Watch(&ping, "ping");
+    sensor.Watch(&pong, "pong");
+    lib.Register(&owner);
+    lib.Register(&ping);
+    lib.Register(&pong);
+    sensor.Register(lib);
+    lib.Run(sensor);
+
+    TMeasure measure;
+    lib.Send(nullptr, &ping, new TEventPing(1));
+    while (ping.Handled + pong.Handled < total) {
+        lib.Run(sensor);
+    }
+    double seconds = measure.Seconds();
+    CHECK(lib.GetDeferred(&sensor) == 1);
+    CHECK(lib.GetDeferred(&ping) == 0);
+
+    // bootstraps are counted too, the owner takes two sweeps for 12 values
+    Host::AdvanceClock(sensor.Period.MicroSeconds());
+    lib.Run(sensor);
+    lib.Run(sensor);
+    lib.Run(sensor);
+    Host::UseSimulatedClock(false);
+    using ESensor = decltype(sensor)::ESensor;
+    CHECK(owner.SensorData == 12);
+    CHECK(sensor.Sensors[0].Values[ESensor::Events].Value == ping.Handled + 1);
+    CHECK(sensor.Sensors[1].Values[ESensor::Events].Value == pong.Handled + 1);
+    CHECK(sensor.Sensors[0].Values[ESensor::MaxMailbox].Value == 1);
+    CHECK(sensor.Sensors[1].Values[ESensor::Deferred].Value == 0);
+
+    printf("ping-pong with diagnostics, 1 in flight\n");
+    printf("  %lu events in %.3f s: %.0f events/s\n", total, seconds, total / seconds);
+}
+
+// many actors rearming timers with different periods
+class TTicker : public TActorHandlers<TTicker, TEventBootstrap, TEventReceive> {
+public:
+    TTime Period;
+    TTime Expected;
+    TTime Start;
+    TTime Last;
+    unsigned long Ticks = 0;
+    unsigned long Late = 0;
+    uint32_t Hash = 2166136261u;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        Start = Last = context.Now;
+        Expected = context.Now + Period;
+        context.Send(this, this, new TEventReceive(Expected));
+    }
+
+    void Handle(TUniquePtr<TEventReceive> event, const TActorContext& context) {
+        ++Ticks;
+        Last = context.Now;
+        Hash = (Hash ^ (context.Now - Start).MilliSeconds()) * 16777619u;
+        CHECK(!(context.Now < Expected));
+        if (Expected + TTime::MilliSeconds(1) < context.Now) {
+            ++Late;
+        }
+        Expected = context.Now + Period;
+        event->NotBefore = Expected;
+        context.Resend(this, event.Release());
+    }
+};
+
+void BenchTimers() {
+    const unsigned long actors = 64;
+    const unsigned long seconds = 60;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    std::vector<TTicker> tickers(actors);
+    for (unsigned long i = 0; i < actors; ++i) {
+        tickers[i].Period = TTime::MilliSeconds(1 + i % 50);
+        lib.Register(&tickers[i]);
+    }
+
+    TMeasure measure;
+    unsigned long end = millis() + seconds * 1000;
+    while ((long)(end - millis()) > 0) {
+        lib.Run();
+        Host::AdvanceClock(100);
+    }
+    double wall = measure.Seconds();
+    unsigned long ticks = 0;
+    unsigned long late = 0;
+    for (const TTicker& ticker : tickers) {
+        ticks += ticker.Ticks;
+        late += ticker.Late;
+    }
+    Host::UseSimulatedClock(false);
+    CHECK(late == 0);
+
+    printf("timers, %lu actors, %lu simulated s\n", actors, seconds);
+    printf("  %lu ticks in %.3f s: %.0f ticks/s, %.3f heap allocations/tick\n",
+        ticks, wall, ticks / wall, (double)measure.Allocated() / ticks);
+}
+
+// a timeout pushed back by every ping, fires once the pings stop
+class TDebounce : public TActorHandlers<TDebounce, TEventPing, TEventReceive> {
+public:
+    TTimer Quiet;
+    unsigned long Fired = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventPing> event, const TActorContext& context) {
+        if (event->Sequence == 0) {
+            context.Cancel(Quiet);
+        } else {
+            context.Reschedule(Quiet, this, context.Now + TTime::MilliSeconds(10));
+        }
+    }
+
+    void Handle(TUniquePtr<TEventReceive>, const TActorContext&) {
+        ++Fired;
+    }
+};
+
+void BenchTimerHandles() {
+    const unsigned long pings = 100000;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TDebounce debounce;
+    lib.Register(&debounce);
+    lib.Run();
+
+    TMeasure measure;
+    for (unsigned long i = 1; i <= pings; ++i) {
+        lib.Send(nullptr, &debounce, new TEventPing(i));
+        lib.Run();
+        Host::AdvanceClock(100);
+        CHECK(lib.GetDeferred(&debounce) == 1);
+    }
+    double seconds = measure.Seconds();
+    unsigned long allocated = measure.Allocated();
+    CHECK(debounce.Fired == 0);
+    Host::AdvanceClock(10000);
+    lib.Run();
+    lib.Run();
+    CHECK(debounce.Fired == 1);
+    CHECK(!debounce.Quiet.Pending());
+
+    lib.Send(nullptr, &debounce, new TEventPing(1));
+    lib.Send(nullptr, &debounce, new TEventPing(0));
+    lib.Run();
+    CHECK(!debounce.Quiet.Pending() && lib.GetDeferred(&debounce) == 0);
+
+    // blinks while lit used to stack two events each
+    TLedActor led;
+    lib.Register(&led);
+    lib.Run();
+    for (int i = 0; i < 10; ++i) {
+        lib.Send(nullptr, &led, new TEventLedBlink(50));
+    }
+    lib.Run();
+    CHECK(lib.GetDeferred(&led) == 1);
+    Host::AdvanceClock(50000);
+    lib.Run();
+    lib.Run();
+    CHECK(lib.GetDeferred(&led) == 0);
+    Host::UseSimulatedClock(false);
+
+    printf("timer handles, %lu reschedules\n", pings);
+    printf("  %.3f s: %.0f reschedules/s, %lu heap allocations\n", seconds, pings / seconds, allocated);
+}
+
+// the sensors' timer: one record, anchored to the first tick
+class TPeriodic : public TActorHandlers<TPeriodic, TEventBootstrap> {
+public:
+    TTime Period;
+    TTime Start;
+    TTime Last;
+    unsigned long Ticks = 0;
+    unsigned long Missed = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+    TTimer Timer;
+
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        Start = context.Now;
+        context.Start(Timer, this, Period);
+    }
+
+    void OnTimer(TTimer& timer, const TActorContext& context) override {
+        ++Ticks;
+        Missed += timer.GetMissed();
+        Last = context.Now;
+    }
+};
+
+// a 5 s sampler over a day with a busy 7 ms loop, against the Resend pattern
+void BenchDrift() {
+    const unsigned long seconds = 24 * 3600;
+    const unsigned long step = 7000;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TPeriodic periodic;
+    TTicker resend;
+    periodic.Period = resend.Period = TTime::MilliSeconds(5000);
+    lib.Register(&periodic);
+    lib.Register(&resend);
+
+    TMeasure measure;
+    TTime end = TTime::Now() + TTime::Seconds(seconds) + TTime::MicroSeconds(step);
+    while (TTime::Now() < end) {
+        lib.Run();
+        Host::AdvanceClock(step);
+    }
+    double wall = measure.Seconds();
+    unsigned long expected = seconds / 5;
+    // every tick is on its own phase, at most one loop pass late
+    CHECK(periodic.Ticks == expected && periodic.Missed == 0);
+    CHECK(periodic.Last - periodic.Start - TTime::MicroSeconds(5000000ull * expected) < TTime::MicroSeconds(step));
+    CHECK(lib.GetDeferred(&periodic) == 1);
+    double drift = (resend.Last - resend.Start).MilliSeconds() / 1000.0 - resend.Ticks * 5.0;
+
+    // a stall over two periods skips one tick and keeps the phase
+    unsigned long ticks = periodic.Ticks;
+    Host::AdvanceClock(12000000);
+    lib.Run();
+    CHECK(periodic.Ticks == ticks + 1 && periodic.Missed == 1);
+    for (int i = 0; i < 1000; ++i) {
+        lib.Run();
+        Host::AdvanceClock(step);
+    }
+    CHECK(periodic.Ticks == ticks + 2);
+    CHECK((periodic.Last - periodic.Start).MicroSeconds() % 5000000 < step);
+    Host::UseSimulatedClock(false);
+
+    printf("periodic timer, 5 s over a simulated day, %lu us loop\n", step);
+    printf("  %lu ticks on phase, resend: %lu ticks, %.1f s behind, %.3f s\n",
+        periodic.Ticks - 2, resend.Ticks, drift, wall);
+}
+
+// an I2C sensor whose reading blocks the loop for Cost
+class TBlockingSensor : public TActorHandlers<TBlockingSensor, TEventBootstrap> {
+public:
+    TTime Period = TTime::MilliSeconds(5000);
+    TTime Cost = TTime::MilliSeconds(15);
+    bool Aligned = false;
+    unsigned long Ticks = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+    TTimer Timer;
+
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        if (Aligned) {
+            context.Start(Timer, this, Period, context.Now + Period);
+        } else {
+            context.Start(Timer, this, Period);
+        }
+    }
+
+    void OnTimer(TTimer&, const TActorContext&) override {
+        ++Ticks;
+        Host::AdvanceClock(Cost.MicroSeconds());
+    }
+};
+
+// stands for the serial and interrupt work, wants to run every millisecond
+class TPoller : public TActorHandlers<TPoller, TEventBootstrap> {
+public:
+    TTime Last;
+    TTime MaxGap;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+    TTimer Timer;
+
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        context.Start(Timer, this, TTime::MilliSeconds(1), context.Now);
+    }
+
+    void OnTimer(TTimer&, const TActorContext&) override {
+        TTime now = TTime::Now();
+        if (Last != TTime() && now - Last > MaxGap) {
+            MaxGap = now - Last;
+        }
+        Last = now;
+    }
+};
+
+// three 15 ms sensors every 5 s next to a 1 ms poller, 60 s on the simulated
+// clock in 100 us steps. in step the sensors share one deadline, and since
+// equal deadlines fire in send order all three reads run back to back ahead
+// of the poller: its worst gap is 3 x 15 ms plus its own 1 ms, 46.0 ms.
+// staggered it is one read plus a period, 16.0 ms
+TTime BenchStagger(bool aligned) {
+    const unsigned long seconds = 60;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TBlockingSensor sensors[3];
+    TPoller poller;
+    for (TBlockingSensor& sensor : sensors) {
+        sensor.Aligned = aligned;
+        lib.Register(&sensor);
+    }
+    lib.Register(&poller);
+
+    TTime end = TTime::Now() + TTime::Seconds(seconds);
+    while (TTime::Now() < end) {
+        lib.Run();
+        Host::AdvanceClock(100);
+    }
+    Host::UseSimulatedClock(false);
+    for (TBlockingSensor& sensor : sensors) {
+        CHECK(sensor.Ticks >= seconds / 5 - 1);
+    }
+
+    printf("three 15 ms sensors every 5 s, %s\n", aligned ? "bootstrapped in step" : "phase staggered");
+    printf("  max gap of a 1 ms poller %.1f ms\n", poller.MaxGap.MicroSeconds() / 1000.0);
+    return poller.MaxGap;
+}
+
+// bulk telemetry formatting, blocks the loop for 2 ms per event
+class TFormatter : public TActorHandlers<TFormatter, TEventPing> {
+public:
+    unsigned long Handled = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventPing>, const TActorContext&) {
+        ++Handled;
+        Host::AdvanceClock(2000);
+    }
+};
+
+// drains the serial receive buffer, wants to run as often as possible
+class TRxPoller : public TActorHandlers<TRxPoller, TEventBootstrap, TEventReceive> {
+public:
+    EPriority Priority = EPriority::Normal;
+    TTime Last;
+    TTime MaxGap;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventBootstrap>, const TActorContext& context) {
+        TEventPtr receive = new TEventReceive;
+        receive->Priority = Priority;
+        context.Send(this, this, receive);
+    }
+
+    void Handle(TUniquePtr<TEventReceive> event, const TActorContext& context) {
+        TTime now = TTime::Now();
+        if (Last != TTime() && now - Last > MaxGap) {
+            MaxGap = now - Last;
+        }
+        Last = now;
+        context.Resend(this, event.Release());
+    }
+};
+
+TTime BenchPriority(EScheduling scheduling, EPriority poll, EPriority bulk) {
+    const unsigned long sweeps = 2000;
+    static const char* names[] = { "low", "normal", "high" };
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TFormatter formatters[8];
+    TRxPoller poller;
+    lib.SetScheduling(scheduling);
+    poller.Priority = poll;
+    for (TFormatter& formatter : formatters) {
+        lib.Register(&formatter);
+    }
+    lib.Register(&poller);
+    lib.Run();
+
+    for (unsigned long i = 0; i < sweeps; ++i) {
+        for (TFormatter& formatter : formatters) {
+            TEventPtr event = new TEventPing(i);
+            event->Priority = bulk;
+            lib.Send(nullptr, &formatter, event);
+        }
+        lib.Run();
+        Host::AdvanceClock(100);
+    }
+    Host::UseSimulatedClock(false);
+    for (TFormatter& formatter : formatters) {
+        CHECK(formatter.Handled >= sweeps - 1);
+    }
+
+    printf("8 formatters blocking 2 ms, %s scheduling, %s poll, %s bulk\n",
+        scheduling == EScheduling::Priority ? "priority" : "deadline", names[(int)poll], names[(int)bulk]);
+    printf("  max gap of the receive poll %.1f ms\n", poller.MaxGap.MicroSeconds() / 1000.0);
+    return poller.MaxGap;
+}
+
+void BenchIdle(bool sleep) {
+    const unsigned long seconds = 10;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TVirtualIdle idle;
+    TTicker ticker;
+    ticker.Period = TTime::MilliSeconds(100);
+    if (sleep) {
+        lib.SetIdle(&idle);
+    }
+    lib.Register(&ticker);
+
+    unsigned long runs = 0;
+    unsigned long end = millis() + seconds * 1000;
+    while ((long)(end - millis()) > 0) {
+        lib.Run();
+        ++runs;
+        // what one pass of loop() costs on the board, roughly
+        Host::AdvanceClock(50);
+    }
+    Host::UseSimulatedClock(false);
+    CHECK(ticker.Ticks >= seconds * 10 - 1 && ticker.Ticks <= seconds * 10);
+
+    printf("idle %s, one 100 ms timer, %lu simulated s\n", sleep ? "sleeping" : "polling", seconds);
+    printf("  %lu ticks, %lu runs, %.1f runs/tick, %lu sleeps\n",
+        ticker.Ticks, runs, (double)runs / ticker.Ticks, idle.Jumps);
+}
+
+struct TSoakResult {
+    unsigned long Ticks = 0;
+    unsigned long Runs = 0;
+    unsigned long MaxDrift = 0;
+    uint32_t Hash = 0;
+};
+
+// a day of sensor-like timers on virtual time
+TSoakResult Soak(unsigned long hours, uint64_t startMicros) {
+    const unsigned long periods[] = { 250, 500, 1000, 1500, 3000, 5000, 8000, 10000, 30000, 60000 };
+    const unsigned long actors = sizeof(periods) / sizeof(periods[0]);
+    Host::UseSimulatedClock(true, startMicros);
+    TActorLib lib;
+    TVirtualIdle idle;
+    TTicker tickers[actors];
+    lib.SetIdle(&idle);
+    for (unsigned long i = 0; i < actors; ++i) {
+        tickers[i].Period = TTime::MilliSeconds(periods[i]);
+        lib.Register(&tickers[i]);
+    }
+
+    TSoakResult result;
+    unsigned long begin = millis();
+    while ((uint32_t)(millis() - begin) < hours * 3600 * 1000) {
+        lib.Run();
+        ++result.Runs;
+    }
+    for (const TTicker& ticker : tickers) {
+        unsigned long elapsed = (ticker.Last - ticker.Start).MilliSeconds();
+        unsigned long scheduled = ticker.Ticks * ticker.Period.MilliSeconds();
+        unsigned long drift = elapsed > scheduled ? elapsed - scheduled : scheduled - elapsed;
+        result.MaxDrift = max(result.MaxDrift, drift);
+        result.Ticks += ticker.Ticks;
+        result.Hash = (result.Hash ^ ticker.Hash) * 16777619u;
+    }
+    Host::UseSimulatedClock(false);
+    return result;
+}
+
+void BenchSoak() {
+    const unsigned long hours = 24;
+    TMeasure measure;
+    TSoakResult first = Soak(hours, 0);
+    double wall = measure.Seconds();
+    // the same day across the millis() rollover at 49.7 days
+    TSoakResult second = Soak(hours, (0x100000000ull - 3600 * 1000) * 1000);
+    CHECK(first.Hash == second.Hash);
+    CHECK(first.Ticks == second.Ticks);
+    CHECK(first.MaxDrift == 0);
+
+    printf("soak, 10 timers, %lu virtual h\n", hours);
+    printf("  %lu ticks, %lu runs in %.3f s: %.0f virtual s/s, max drift %lu ms, replay over rollover identical\n",
+        first.Ticks, first.Runs, wall, hours * 3600 / wall, first.MaxDrift);
+}
+
+class TInterruptSink : public TActorHandlers<TInterruptSink, TEventInterrupt> {
+public:
+    uint16_t Expected = 0;
+    unsigned long Handled = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventInterrupt> event, const TActorContext&) {
+        CHECK(event->Value == Expected);
+        ++Expected;
+        ++Handled;
+    }
+};
+
+void BenchInterrupts() {
+    const unsigned long total = 1000000;
+    TActorLib lib;
+    TInterruptSink sink;
+    lib.Register(&sink);
+    lib.Run();
+
+    TMeasure measure;
+    uint16_t value = 0;
+    while (sink.Handled < total) {
+        for (int i = 0; i < AW_INTERRUPT_QUEUE; ++i) {
+            CHECK(lib.SendFromInterrupt(&sink, value++));
+        }
+        lib.Run();
+    }
+    double seconds = measure.Seconds();
+    CHECK(lib.GetInterruptsDropped() == 0);
+
+    printf("interrupts, bursts of %d\n", AW_INTERRUPT_QUEUE);
+    printf("  %lu events in %.3f s: %.0f events/s, %.3f heap allocations/event\n",
+        sink.Handled, seconds, sink.Handled / seconds, (double)measure.Allocated() / sink.Handled);
+}
+
+// the library actors of a typical sketch against the stub board
+void BenchSketch() {
+    const unsigned long seconds = 60;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TVirtualIdle idle;
+    TOwner owner;
+    TSerialActor<THardwareSerial<Serial, 115200>> serial(&owner);
+    TSensorMemory memory(&owner);
+    TSensorBME280<> bme280(&owner);
+    TSensorBMP280<> bmp280(&owner);
+    TSensorINA219<> ina219(&owner);
+    TSensorAM2320<> am2320(&owner);
+    TSensorVoltage<1> voltage(&owner);
+    TSensorCT<2> ct(&owner);
+    TSensorCounter<3> counter(&owner);
+    TSensorEnergy energy(&owner, 1, 1, 1, 2, 1);
+    TLedActor led;
+    DisplaySSD1306 display;
+    lib.SetIdle(&idle);
+    lib.Register(&owner);
+    lib.Register(&serial);
+    lib.Register(&memory);
+    lib.Register(&bme280);
+    lib.Register(&bmp280);
+    lib.Register(&ina219);
+    lib.Register(&am2320);
+    lib.Register(&voltage);
+    lib.Register(&ct);
+    lib.Register(&counter);
+    lib.Register(&energy);
+    lib.Register(&led);
+    lib.Register(&display);
+    Serial.Feed("hello\r\nworld\n", 13);
+
+    TMeasure measure;
+    unsigned long runs = 0;
+    unsigned long end = millis() + seconds * 1000;
+    while ((long)(end - millis()) > 0) {
+        lib.Run();
+        ++runs;
+        Host::AdvanceClock(50);
+    }
+    double wall = measure.Seconds();
+    Host::UseSimulatedClock(false);
+    CHECK(owner.SensorData > 0);
+    CHECK(owner.Other > 0);
+
+    printf("sketch, %lu simulated s\n", seconds);
+    printf("  %lu sensor values, %lu other events, %lu runs in %.3f s\n", owner.SensorData, owner.Other, runs, wall);
+}
+
+// an actor whose constructor wants more than its owner gets a small class of its own
+class TWorkflowEnergy : public TSensorEnergy {
+public:
+    TWorkflowEnergy(TActor* owner)
+        : TSensorEnergy(owner, 1, 1, 1, 2, 1)
+    {}
+};
+
+// the same sketch as a TArduinoWorkflow, actors needing an owner wired to it
+void BenchSketchStatic() {
+    const unsigned long seconds = 60;
+    Host::UseSimulatedClock(true);
+    TArduinoWorkflow<
+        TOwner,
+        TArduinoWired<TSerialActor<THardwareSerial<Serial, 115200>>, 0>,
+        TArduinoWired<TSensorMemory, 0>,
+        TArduinoWired<TSensorBME280<>, 0>,
+        TArduinoWired<TSensorBMP280<>, 0>,
+        TArduinoWired<TSensorINA219<>, 0>,
+        TArduinoWired<TSensorAM2320<>, 0>,
+        TArduinoWired<TSensorVoltage<1>, 0>,
+        TArduinoWired<TSensorCT<2>, 0>,
+        TArduinoWired<TSensorCounter<3>, 0>,
+        TArduinoWired<TWorkflowEnergy, 0>,
+        TLedActor,
+        DisplaySSD1306> workflow;
+    TVirtualIdle idle;
+    TOwner& owner = workflow.Get<0>();
+    workflow.SetIdle(&idle);
+    workflow.Begin();
+    Serial.Feed("hello\r\nworld\n", 13);
+
+    TMeasure measure;
+    unsigned long runs = 0;
+    unsigned long end = millis() + seconds * 1000;
+    while ((long)(end - millis()) > 0) {
+        workflow.Run();
+        ++runs;
+        Host::AdvanceClock(50);
+    }
+    double wall = measure.Seconds();
+    Host::UseSimulatedClock(false);
+    CHECK(owner.SensorData > 0);
+    CHECK(owner.Other > 0);
+
+    printf("sketch, static workflow, %lu simulated s\n", seconds);
+    printf("  %lu sensor values, %lu other events, %lu runs in %.3f s\n", owner.SensorData, owner.Other, runs, wall);
+}
+
+}
+
+int main() {
+    printf("event pools: small %d x %u bytes, large %d x %u bytes\n",
+        TEventPools::TSmall::GetBlockCount(), (unsigned)TEventPools::TSmall::GetBlockSize(),
+        TEventPools::TLarge::GetBlockCount(), (unsigned)TEventPools::TLarge::GetBlockSize());
+    BenchPingPong(1);
+    BenchPingPong(8);
+    BenchStaticDispatch();
+    BenchDiagnostics();
+    BenchChain(false);
+    BenchChain(true);
+    BenchBudget(1, 0);
+    BenchBudget(8, 0);
+    BenchBudget(64, 0);
+    BenchBudget(64, 20);
+    BenchBatch(false);
+    BenchBatch(true);
+    BenchSerialData("t=21.5\n");
+    BenchSerialData("sensor.temperature=21.5\n");
+    BenchFormatFloat();
+    BenchStringMove();
+    BenchSplitLines();
+    BenchFormat<StringStream>("stream");
+    BenchFormat<TSensorText>("static string");
+    BenchOverflow<EOverflow::DropNewest>("drop newest", { 0, 1, 2, 3 });
+    BenchOverflow<EOverflow::DropLowest>("drop lowest", { 6, 7, 8, 9 });
+    BenchOverflow<EOverflow::Coalesce>("coalesce", { 6, 7, 8, 9 });
+    BenchTimers();
+    BenchTimerHandles();
+    BenchDrift();
+    TTime aligned = BenchStagger(true);
+    TTime staggered = BenchStagger(false);
+    CHECK(staggered < TTime::MilliSeconds(17) && staggered < aligned);
+    TTime fifo = BenchPriority(EScheduling::Priority, EPriority::Normal, EPriority::Normal);
+    TTime urgent = BenchPriority(EScheduling::Priority, EPriority::High, EPriority::Low);
+    TTime deadline = BenchPriority(EScheduling::Deadline, EPriority::High, EPriority::Low);
+    CHECK(urgent <= TTime::MilliSeconds(3) && deadline <= TTime::MilliSeconds(3) && fifo > urgent);
+    BenchIdle(false);
+    BenchIdle(true);
+    BenchSoak();
+    BenchInterrupts();
+    BenchSketch();
+    BenchSketchStatic();
+    printf("pool small max used %d overflows %d, large max used %d overflows %d\n",
+        TEventPools::Small.GetMaxUsed(), TEventPools::Small.GetOverflows(),
+        TEventPools::Large.GetMaxUsed(), TEventPools::Large.GetOverflows());
+    return 0;
+}
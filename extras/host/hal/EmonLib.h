@@ -0,0 +1,15 @@
+#pragma once
+
+class EnergyMonitor {
+public:
+    void voltage(unsigned int, double, double) {}
+    void current(unsigned int, double) {}
+    void calcVI(unsigned int, unsigned int) {}
+    double calcIrms(unsigned int) { return Irms; }
+
+    double realPower = 0;
+    double apparentPower = 0;
+    double powerFactor = 0;
+    double Vrms = 0;
+    double Irms = 0;
+};
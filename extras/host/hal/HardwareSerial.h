@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// In-memory serial port: bytes written by the sketch are collected in Output,
+// bytes fed by the host side are returned from read calls.
+class HardwareSerial {
+public:
+    void begin(long baud);
+    int available();
+    int availableForWrite();
+    size_t write(const char* buffer, size_t length);
+    size_t write(uint8_t value);
+    size_t readBytes(char* buffer, size_t length);
+    size_t print(const char* string);
+    size_t println(const char* string);
+    size_t println(int value);
+
+    void Feed(const char* buffer, size_t length);
+    void ClearOutput();
+
+    static constexpr size_t BufferSize = 1024;
+    char Input[BufferSize];
+    size_t InputBegin = 0;
+    size_t InputEnd = 0;
+    size_t OutputSize = 0;
+    size_t WriteWindow = 64;
+    bool Echo = false;
+};
+
+extern HardwareSerial Serial;
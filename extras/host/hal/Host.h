@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+// controls of the simulated board, not part of the Arduino API
+namespace Host {
+
+// millis() and micros() stop following the wall clock and move only
+// with AdvanceClock() and delay(), starting from start like a board after reset
+void UseSimulatedClock(bool simulated, uint64_t startMicroseconds = 0);
+void AdvanceClock(unsigned long microseconds);
+
+// wall clock in nanoseconds, for measurements
+uint64_t Nanos();
+
+}
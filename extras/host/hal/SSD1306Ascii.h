@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+
+struct DevType {};
+static const DevType Adafruit128x64 = {};
+static const uint8_t Adafruit5x7[] = { 0 };
+
+class SSD1306Ascii {
+public:
+    void setContrast(uint8_t) {}
+    void ssd1306WriteCmd(uint8_t) {}
+    void setFont(const uint8_t*) {}
+    void setScroll(bool) {}
+    void clear() {}
+    size_t write(uint8_t) { return 1; }
+    size_t println() { return 1; }
+};
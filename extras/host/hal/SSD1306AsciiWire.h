@@ -0,0 +1,8 @@
+#pragma once
+
+#include "SSD1306Ascii.h"
+
+class SSD1306AsciiWire : public SSD1306Ascii {
+public:
+    void begin(const DevType*, uint8_t) {}
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "HardwareSerial.h"
+
+class SoftwareSerial : public HardwareSerial {
+public:
+    SoftwareSerial(uint8_t rxPin, uint8_t txPin)
+        : RxPin(rxPin)
+        , TxPin(txPin)
+    {}
+
+    uint8_t RxPin;
+    uint8_t TxPin;
+};
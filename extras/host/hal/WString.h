@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+
+// enough of Arduino's String for the library headers
+class String {
+public:
+    String(const char* value = "")
+        : Data(value)
+    {}
+
+    String(int value, unsigned char base = 10)
+        : String((long)value, base)
+    {}
+
+    String(unsigned int value, unsigned char base = 10)
+        : String((unsigned long)value, base)
+    {}
+
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+
+    explicit String(float value, unsigned char decimals = 2)
+        : String((double)value, decimals)
+    {}
+
+    explicit String(double value, unsigned char decimals = 2) {
+        char buffer[40];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        Data = buffer;
+    }
+
+    const char* c_str() const {
+        return Data.c_str();
+    }
+
+    unsigned int length() const {
+        return Data.size();
+    }
+
+    String& operator +=(const String& other) {
+        Data += other.Data;
+        return *this;
+    }
+
+    bool operator ==(const String& other) const {
+        return Data == other.Data;
+    }
+
+    bool operator !=(const String& other) const {
+        return Data != other.Data;
+    }
+
+protected:
+    std::string Data;
+};
+
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& value)
+        : String(value)
+    {}
+};
+
+inline StringSumHelper operator +(const String& left, const String& right) {
+    StringSumHelper result(left);
+    result += right;
+    return result;
+}
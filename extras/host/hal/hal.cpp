@@ -0,0 +1,219 @@
+#include "Arduino.h"
+#include "Host.h"
+#include "Wire.h"
+#include "avr/eeprom.h"
+#include "avr/wdt.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+
+HardwareSerial Serial;
+TwoWire Wire;
+
+unsigned int __bss_end;
+unsigned int __heap_start;
+void* __brkval;
+
+namespace {
+
+const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+bool Simulated = false;
+uint64_t SimulatedMicros = 0;
+uint8_t Pins[256];
+uint8_t EEPROM[1024];
+
+char* ToString(unsigned long value, char* buffer, int base, bool negative) {
+    char* p = buffer;
+    if (negative) {
+        *p++ = '-';
+    }
+    char* begin = p;
+    do {
+        int digit = value % base;
+        *p++ = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value != 0);
+    *p = '\0';
+    for (char* end = p - 1; begin < end; ++begin, --end) {
+        char c = *begin;
+        *begin = *end;
+        *end = c;
+    }
+    return buffer;
+}
+
+}
+
+uint64_t Host::Nanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+}
+
+void Host::UseSimulatedClock(bool simulated, uint64_t startMicroseconds) {
+    SimulatedMicros = startMicroseconds;
+    Simulated = simulated;
+}
+
+void Host::AdvanceClock(unsigned long microseconds) {
+    SimulatedMicros += microseconds;
+}
+
+// counters wrap at 32 bits like they do on the board
+unsigned long millis() {
+    return (uint32_t)((Simulated ? SimulatedMicros : Host::Nanos() / 1000) / 1000);
+}
+
+unsigned long micros() {
+    return (uint32_t)(Simulated ? SimulatedMicros : Host::Nanos() / 1000);
+}
+
+void delay(unsigned long ms) {
+    if (Simulated) {
+        Host::AdvanceClock(ms * 1000);
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+void delayMicroseconds(unsigned int us) {
+    if (Simulated) {
+        Host::AdvanceClock(us);
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    Pins[pin] = value;
+}
+
+int digitalRead(uint8_t pin) {
+    return Pins[pin];
+}
+
+int analogRead(uint8_t pin) {
+    return Pins[pin];
+}
+
+void analogWrite(uint8_t pin, int value) {
+    Pins[pin] = value;
+}
+
+void attachInterrupt(uint8_t, void (*)(), int) {}
+void detachInterrupt(uint8_t) {}
+void noInterrupts() {}
+void interrupts() {}
+
+char* itoa(int value, char* buffer, int base) {
+    return ltoa(value, buffer, base);
+}
+
+char* utoa(unsigned int value, char* buffer, int base) {
+    return ToString(value, buffer, base, false);
+}
+
+char* ltoa(long value, char* buffer, int base) {
+    if (value < 0 && base == 10) {
+        return ToString(-(unsigned long)value, buffer, base, true);
+    }
+    return ToString(value, buffer, base, false);
+}
+
+char* ultoa(unsigned long value, char* buffer, int base) {
+    return ToString(value, buffer, base, false);
+}
+
+char* dtostrf(double value, signed char width, unsigned char precision, char* buffer) {
+    sprintf(buffer, "%*.*f", width, precision, value);
+    return buffer;
+}
+
+String::String(long value, unsigned char base) {
+    char buffer[72];
+    Data = ltoa(value, buffer, base);
+}
+
+String::String(unsigned long value, unsigned char base) {
+    char buffer[72];
+    Data = ultoa(value, buffer, base);
+}
+
+uint8_t eeprom_read_byte(const uint8_t* address) {
+    return EEPROM[reinterpret_cast<uintptr_t>(address) % sizeof(EEPROM)];
+}
+
+void eeprom_write_byte(uint8_t* address, uint8_t value) {
+    EEPROM[reinterpret_cast<uintptr_t>(address) % sizeof(EEPROM)] = value;
+}
+
+void wdt_enable(int) {}
+void wdt_disable() {}
+void wdt_reset() {}
+
+void HardwareSerial::begin(long) {}
+
+int HardwareSerial::available() {
+    return InputEnd - InputBegin;
+}
+
+int HardwareSerial::availableForWrite() {
+    return WriteWindow;
+}
+
+size_t HardwareSerial::write(const char* buffer, size_t length) {
+    if (Echo) {
+        fwrite(buffer, 1, length, stdout);
+    }
+    OutputSize += length;
+    return length;
+}
+
+size_t HardwareSerial::write(uint8_t value) {
+    char c = value;
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::readBytes(char* buffer, size_t length) {
+    size_t size = InputEnd - InputBegin;
+    if (length > size) {
+        length = size;
+    }
+    memcpy(buffer, Input + InputBegin, length);
+    InputBegin += length;
+    if (InputBegin == InputEnd) {
+        InputBegin = InputEnd = 0;
+    }
+    return length;
+}
+
+size_t HardwareSerial::print(const char* string) {
+    return write(string, strlen(string));
+}
+
+size_t HardwareSerial::println(const char* string) {
+    return print(string) + print("\r\n");
+}
+
+size_t HardwareSerial::println(int value) {
+    char buffer[16];
+    return println(itoa(value, buffer, 10));
+}
+
+void HardwareSerial::Feed(const char* buffer, size_t length) {
+    if (InputBegin != 0) {
+        memmove(Input, Input + InputBegin, InputEnd - InputBegin);
+        InputEnd -= InputBegin;
+        InputBegin = 0;
+    }
+    if (length > BufferSize - InputEnd) {
+        length = BufferSize - InputEnd;
+    }
+    memcpy(Input + InputEnd, buffer, length);
+    InputEnd += length;
+}
+
+void HardwareSerial::ClearOutput() {
+    OutputSize = 0;
+}
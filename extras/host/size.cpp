@@ -0,0 +1,64 @@
+// one sketch built twice for `make size`: with the actors registered in a
+// TActorLib, and with -DAW_SKETCH_STATIC as a TArduinoWorkflow
+#include <ArduinoWorkflow.h>
+#include <Host.h>
+#include "VirtualTime.h"
+
+using namespace AW;
+
+namespace {
+
+class TOwner : public TActor {
+public:
+    unsigned long SensorData = 0;
+
+    void OnEvent(TEventPtr event, const TActorContext&) override {
+        if (event->EventID == EventSensorData) {
+            ++SensorData;
+        }
+    }
+};
+
+using TSerial = TSerialActor<THardwareSerial<Serial, 115200>>;
+
+}
+
+int main() {
+    Host::UseSimulatedClock(true);
+    TVirtualIdle idle;
+#ifdef AW_SKETCH_STATIC
+    TArduinoWorkflow<
+        TOwner,
+        TArduinoWired<TSerial, 0>,
+        TArduinoWired<TSensorMemory, 0>,
+        TArduinoWired<TSensorBME280<>, 0>,
+        TArduinoWired<TSensorVoltage<1>, 0>,
+        TArduinoWired<TSensorCounter<3>, 0>,
+        TLedActor> lib;
+    TOwner& owner = lib.Get<0>();
+    lib.SetIdle(&idle);
+    lib.Begin();
+#else
+    TActorLib lib;
+    TOwner owner;
+    TSerial serial(&owner);
+    TSensorMemory memory(&owner);
+    TSensorBME280<> bme280(&owner);
+    TSensorVoltage<1> voltage(&owner);
+    TSensorCounter<3> counter(&owner);
+    TLedActor led;
+    lib.SetIdle(&idle);
+    lib.Register(&owner);
+    lib.Register(&serial);
+    lib.Register(&memory);
+    lib.Register(&bme280);
+    lib.Register(&voltage);
+    lib.Register(&counter);
+    lib.Register(&led);
+#endif
+    for (int i = 0; i < 100000; ++i) {
+        lib.Run();
+        Host::AdvanceClock(50);
+    }
+    return owner.SensorData > 0 ? 0 : 1;
+}
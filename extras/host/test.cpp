@@ -0,0 +1,548 @@
+// sketch-level checks of the library against the stub board, see extras/host/Makefile
+#include <ArduinoWorkflow.h>
+#include <Host.h>
+#include "Check.h"
+#include "VirtualTime.h"
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace AW;
+
+namespace {
+
+struct TEventSequence : TBasicEvent<TEventSequence> {
+    constexpr static TEventID EventID = EventUser;
+    unsigned long Sequence;
+
+    TEventSequence(unsigned long sequence)
+        : Sequence(sequence)
+    {}
+};
+
+// FormatFloat against the host's printf, every decimals count over random
+// bit patterns, exact ties and the edges of the range
+void CheckFormatFloat() {
+    auto check = [](float value, uint8_t decimals) {
+        char expected[64];
+        snprintf(expected, sizeof(expected), "%.*f", decimals, (double)value);
+        char buf[FloatTextSize];
+        char* end = buf + sizeof(buf);
+        char* begin = FormatFloat(end, value, decimals);
+        if (!(StringBuf(begin, end) == StringBuf(StringPointer(expected)))) {
+            fprintf(stderr, "%.9g with %u decimals: %.*s, printf %s\n", (double)value, decimals, (int)(end - begin), begin, expected);
+            exit(1);
+        }
+    };
+    const float values[] = { 0.0f, -0.0f, 0.5f, 1.5f, 2.5f, -2.5f, 0.125f, 0.375f, 1e-45f, 1e-10f, 0.005f, 0.015f,
+        21.345f, 99.995f, 999999.5f, 16777215.0f, 16777217.0f, 4294967040.0f, -4294967040.0f };
+    for (float value : values) {
+        for (uint8_t decimals = 0; decimals <= 9; ++decimals) {
+            check(value, decimals);
+        }
+    }
+    uint32_t seed = 1;
+    for (unsigned long i = 0; i < 1000000; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        // exponents up to 2^32, those above print as "ovf"
+        uint32_t bits = (seed & 0x807fffff) | ((seed >> 8) % 159) << 23;
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        check(value, i % 10);
+    }
+    for (long value = -100000; value <= 100000; ++value) {
+        check(value / 100.0f, 2);
+        check(value / 8.0f, 2);
+    }
+    char buf[FloatTextSize];
+    char* end = buf + sizeof(buf);
+    CHECK(StringBuf(FormatFloat(end, 4294967296.0f, 2), end) == "ovf");
+    CHECK(StringBuf(FormatFloat(end, -1e30f, 2), end) == "ovf");
+    CHECK(StringBuf(FormatFloat(end, 1.0f / 0.0f, 2), end) == "inf");
+    CHECK(StringBuf(FormatFloat(end, -1.0f / 0.0f, 2), end) == "-inf");
+    CHECK(StringBuf(FormatFloat(end, 0.0f / 0.0f, 2), end) == "nan");
+    TStaticString<16> text;
+    text << TFixed(215, 1) << ' ' << TFixed(-5, 2) << ' ' << TFixed(7, 0);
+    CHECK(text == "21.5 -0.05 7");
+}
+
+void CheckStaticString() {
+    TStaticString<8> text = "temp";
+    text << '=' << -21;
+    CHECK(text == "temp=-21" && !text.truncated());
+    text.erase(0, 5);
+    text += "5.5";
+    CHECK(text == "-215.5");
+    // past the end erases nothing, over the end erases the rest
+    text.erase(7, 1);
+    text.erase(6, 1);
+    CHECK(text == "-215.5");
+    text.erase(4, StringBuf::npos);
+    CHECK(text == "-215");
+    text += ".5";
+    text << "000";
+    CHECK(text == "-215.500" && text.truncated());
+    text.clear();
+    CHECK(text.empty() && !text.truncated());
+    TStaticString<8> copy = text;
+    copy << 123456789UL;
+    CHECK(copy == "12345678" && copy.truncated());
+    AW::String string = copy;
+    CHECK(string == "12345678");
+}
+
+// records the order events arrive in
+class TFifo : public TActorHandlers<TFifo, TEventSequence> {
+public:
+    unsigned long Next = 0;
+    unsigned long OutOfOrder = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventSequence> event, const TActorContext&) {
+        if (event->Sequence != Next) {
+            ++OutOfOrder;
+        }
+        Next = event->Sequence + 1;
+    }
+};
+
+// records the order of the events let into a mailbox of four
+class TShedding : public TActorHandlers<TShedding, TMailbox<4, EOverflow::DropLowest>, TEventSequence> {
+public:
+    std::vector<unsigned long> Seen;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventSequence> event, const TActorContext&) {
+        Seen.push_back(event->Sequence);
+    }
+};
+
+// a full mailbox sheds its oldest normal event, not the urgent one at its head
+void CheckDropLowest() {
+    TActorLib lib;
+    TShedding shedding;
+    lib.Register(&shedding);
+    lib.Run();
+    for (unsigned long i = 0; i < 5; ++i) {
+        TEventPtr event = new TEventSequence(i);
+        if (i == 3) {
+            event->Priority = EPriority::High;
+        }
+        lib.Send(nullptr, &shedding, event);
+    }
+    lib.Run();
+    CHECK((shedding.Seen == std::vector<unsigned long>{ 3, 1, 2, 4 }));
+    CHECK(shedding.GetDropped() == 1);
+}
+
+// same deadline, sent in order, delivered in order
+void CheckTimerOrder() {
+    const unsigned long events = 100;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TFifo fifo;
+    lib.Register(&fifo);
+    TTime due = TTime::Now() + TTime::MilliSeconds(10);
+    for (unsigned long i = 0; i < events; ++i) {
+        TEventSequence* event = new TEventSequence(i);
+        event->NotBefore = due;
+        lib.Send(nullptr, &fifo, event);
+    }
+    Host::AdvanceClock(20000);
+    for (unsigned long i = 0; i < events && fifo.Next < events; ++i) {
+        lib.Run();
+    }
+    Host::UseSimulatedClock(false);
+    CHECK(fifo.Next == events);
+    CHECK(fifo.OutOfOrder == 0);
+}
+
+class TInterruptLog : public TActorHandlers<TInterruptLog, TEventInterrupt> {
+public:
+    std::vector<uint16_t> Values;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventInterrupt> event, const TActorContext&) {
+        Values.push_back(event->Value);
+    }
+};
+
+// a thread stands in for the ISR and posts while the main thread runs the loop.
+// every value either arrives once and in order, or is counted as dropped
+void CheckInterruptThread() {
+    const unsigned long total = 100000;
+    TActorLib lib;
+    TInterruptLog log;
+    log.Values.reserve(total);
+    lib.Register(&log);
+    lib.Run();
+
+    std::vector<char> accepted(total);
+    std::atomic<bool> done(false);
+    std::thread isr([&]() {
+        for (unsigned long i = 0; i < total; ++i) {
+            accepted[i] = lib.SendFromInterrupt(&log, (uint16_t)i);
+            // bursts a little longer than the queue, so some overrun it
+            if (i % (AW_INTERRUPT_QUEUE + 2) == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+        }
+        done.store(true, std::memory_order_release);
+    });
+    while (!done.load(std::memory_order_acquire)) {
+        lib.Run();
+    }
+    isr.join();
+    for (int i = 0; i <= AW_INTERRUPT_QUEUE; ++i) {
+        lib.Run();
+    }
+
+    unsigned long dropped = 0;
+    size_t received = 0;
+    for (unsigned long i = 0; i < total; ++i) {
+        if (accepted[i]) {
+            CHECK(received < log.Values.size());
+            CHECK(log.Values[received] == (uint16_t)i);
+            ++received;
+        } else {
+            ++dropped;
+        }
+    }
+    CHECK(received == log.Values.size());
+    CHECK(lib.GetInterruptsDropped() == (uint8_t)dropped);
+
+    CHECK(received > 0 && dropped > 0);
+}
+
+// what the main actor of a sketch gets from the library actors
+class TOwner : public TActor {
+public:
+    std::set<std::string> Sources;
+    std::vector<std::string> Lines;
+    unsigned long Messages = 0;
+
+    void OnEvent(TEventPtr event, const TActorContext&) override {
+        switch (event->EventID) {
+        case EventSensorData:
+            Sources.insert(std::string(static_cast<TEventSensorData*>(event.Get())->Source.Name.begin(),
+                static_cast<TEventSensorData*>(event.Get())->Source.Name.end()));
+            break;
+        case EventSerialData: {
+            const TEventString& data = static_cast<TEventSerialData*>(event.Get())->Data;
+            Lines.push_back(std::string(data.begin(), data.end()));
+            break;
+        }
+        case EventSensorMessage:
+            ++Messages;
+            break;
+        }
+    }
+};
+
+// an event dropped through TEventPtr releases the text it carries
+void CheckEventDelete() {
+    AW::String line;
+    line += "a line too long for the inline buffer";
+    CHECK(line._IsUnique());
+    TEventPtr event = new TEventSerialData(line);
+#if !AW_EVENT_STRING
+    CHECK(!line._IsUnique());
+#endif
+    event = nullptr;
+    CHECK(line._IsUnique());
+}
+
+// a received line too long for TEventString is dropped whole, never cut
+void CheckSerialLongLines() {
+    const char input[] = "short\na line over the 32 chars an event holds\nend\n";
+    TActorLib lib;
+    TOwner owner;
+    TSerialActor<THardwareSerial<Serial, 115200>> serial(&owner);
+    lib.Register(&owner);
+    lib.Register(&serial);
+    Serial.Feed(input, sizeof(input) - 1);
+    for (int i = 0; i < 10; ++i) {
+        lib.Run();
+    }
+#if AW_EVENT_STRING
+    CHECK(owner.Lines.size() == 2 && owner.Lines[0] == "short" && owner.Lines[1] == "end");
+    CHECK(serial.GetLongLines() == 1);
+#else
+    CHECK(owner.Lines.size() == 3 && owner.Lines[1] == "a line over the 32 chars an event holds");
+    CHECK(serial.GetLongLines() == 0);
+#endif
+}
+
+// the serial poll waits for its period, so a sketch with a serial port still
+// sleeps between the sensor ticks. the clock only moves by sleeping here
+void CheckSerialSleeps() {
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TOwner owner;
+    TSerialActor<THardwareSerial<Serial, 115200>> serial(&owner);
+    TSensorMemory memory(&owner);
+    TVirtualIdle idle;
+    lib.SetIdle(&idle);
+    lib.Register(&owner);
+    lib.Register(&serial);
+    lib.Register(&memory);
+    unsigned long end = millis() + 10000;
+    for (unsigned long runs = 0; (long)(end - millis()) > 0 && runs < 100000; ++runs) {
+        lib.Run();
+    }
+    bool slept = (long)(end - millis()) <= 0;
+    Host::UseSimulatedClock(false);
+    CHECK(slept);
+    CHECK(owner.Sources.count("memory") != 0);
+}
+
+struct TDiagnosticsEnvironment : TDefaultEnvironment {
+    static constexpr bool Diagnostics = true;
+};
+
+static_assert(std::is_empty<TSensorActors<4>>::value, "disabled diagnostics should take no room");
+
+class TCaller : public TActorHandlers<TCaller, TEventSequence> {
+public:
+    TActor* Callee = nullptr;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventSequence> event, const TActorContext& context) {
+        context.Call(this, Callee, event.Release());
+    }
+};
+
+class TCallee : public TActorHandlers<TCallee, TEventSequence> {
+public:
+    unsigned long Handled = 0;
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventSequence>, const TActorContext&) {
+        ++Handled;
+    }
+};
+
+class TBatchedCallee : public TActorHandlers<TBatchedCallee, TEventSequence> {
+public:
+    unsigned long Batches = 0;
+
+    TBatchedCallee() {
+        TActor::SetBatched(true);
+    }
+
+protected:
+    friend struct AW::TEventHandlerAccess;
+
+    void Handle(TUniquePtr<TEventSequence>, const TActorContext&) {}
+
+    void OnEventBatch(TEventBatch& batch, const TActorContext& context) override {
+        ++Batches;
+        TActor::OnEventBatch(batch, context);
+    }
+};
+
+// Call delivers in place through the sweep's dispatch, a batched recipient
+// gets a batch of one. outside a sweep it only queues
+void CheckCallBatched() {
+    TActorLib lib;
+    TCaller caller;
+    TBatchedCallee callee;
+    caller.Callee = &callee;
+    lib.Register(&caller);
+    lib.Register(&callee);
+    lib.Run();
+    // the bootstrap came in a batch too
+    unsigned long batches = callee.Batches;
+    for (unsigned long i = 0; i < 3; ++i) {
+        lib.Send(nullptr, &caller, new TEventSequence(i));
+        lib.Run();
+        CHECK(callee.Batches == batches + i + 1);
+    }
+    TActorContext context(lib);
+    lib.Call(nullptr, &callee, new TEventSequence(3), context);
+    CHECK(callee.Batches == batches + 3);
+    lib.Run();
+    CHECK(callee.Batches == batches + 4);
+}
+
+// handlers run in place by Call are counted like those run by the sweep
+void CheckDiagnosticsCall() {
+    const unsigned long events = 10;
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TOwner owner;
+    TCaller caller;
+    TCallee callee;
+    TSensorActors<2, TDiagnosticsEnvironment> sensor(&owner);
+    caller.Callee = &callee;
+    sensor.Period = TTime::Seconds(1000);
+    sensor.Watch(&caller, "caller");
+    sensor.Watch(&callee, "callee");
+    lib.Register(&caller);
+    lib.Register(&callee);
+    sensor.Register(lib);
+    lib.Run(sensor);
+    for (unsigned long i = 0; i < events; ++i) {
+        lib.Send(nullptr, &caller, new TEventSequence(i));
+        lib.Run(sensor);
+    }
+    Host::AdvanceClock(sensor.Period.MicroSeconds());
+    lib.Run(sensor);
+    Host::UseSimulatedClock(false);
+    CHECK(callee.Handled == events);
+    // the actors' bootstraps are counted as well
+    using ESensor = decltype(sensor)::ESensor;
+    CHECK(sensor.Sensors[0].Values[ESensor::Events].Value == events + 1);
+    CHECK(sensor.Sensors[1].Values[ESensor::Events].Value == events + 1);
+}
+
+template <typename LibType>
+void RunSketch(LibType& lib, TOwner& owner, TActor* serial) {
+    const unsigned long seconds = 60;
+    TVirtualIdle idle;
+    lib.SetIdle(&idle);
+    Serial.ClearOutput();
+    Serial.Feed("hello\r\nworld\n", 13);
+    lib.Send(nullptr, serial, new TEventSerialData("ping"));
+    unsigned long end = millis() + seconds * 1000;
+    while ((long)(end - millis()) > 0) {
+        lib.Run();
+        Host::AdvanceClock(50);
+    }
+    CHECK(owner.Lines.size() == 2 && owner.Lines[0] == "hello" && owner.Lines[1] == "world");
+    CHECK(Serial.OutputSize == 5);
+    // the stub Wire reads zeros, the BME280 and BMP280 fail their chip ID checks
+    const char* sources[] = { "memory", "ina219", "voltage", "ct" };
+    for (const char* source : sources) {
+        if (owner.Sources.count(source) == 0) {
+            fprintf(stderr, "no values from %s\n", source);
+            exit(1);
+        }
+    }
+}
+
+// the library actors of a typical sketch, 60 simulated seconds
+void CheckSketch() {
+    Host::UseSimulatedClock(true);
+    TActorLib lib;
+    TOwner owner;
+    TSerialActor<THardwareSerial<Serial, 115200>> serial(&owner);
+    TSensorMemory memory(&owner);
+    TSensorBME280<> bme280(&owner);
+    TSensorBMP280<> bmp280(&owner);
+    TSensorINA219<> ina219(&owner);
+    TSensorVoltage<1> voltage(&owner, "voltage");
+    TSensorCT<2> ct(&owner);
+    TSensorCounter<3> counter(&owner);
+    TLedActor led;
+    lib.Register(&owner);
+    lib.Register(&serial);
+    lib.Register(&memory);
+    lib.Register(&bme280);
+    lib.Register(&bmp280);
+    lib.Register(&ina219);
+    lib.Register(&voltage);
+    lib.Register(&ct);
+    lib.Register(&counter);
+    lib.Register(&led);
+    RunSketch(lib, owner, &serial);
+    Host::UseSimulatedClock(false);
+}
+
+class TWorkflowVoltage : public TSensorVoltage<1> {
+public:
+    TWorkflowVoltage(TActor* owner)
+        : TSensorVoltage<1>(owner, "voltage")
+    {}
+};
+
+// the same sketch as a TArduinoWorkflow
+void CheckSketchStatic() {
+    Host::UseSimulatedClock(true);
+    TArduinoWorkflow<
+        TOwner,
+        TArduinoWired<TSerialActor<THardwareSerial<Serial, 115200>>, 0>,
+        TArduinoWired<TSensorMemory, 0>,
+        TArduinoWired<TSensorBME280<>, 0>,
+        TArduinoWired<TSensorBMP280<>, 0>,
+        TArduinoWired<TSensorINA219<>, 0>,
+        TArduinoWired<TWorkflowVoltage, 0>,
+        TArduinoWired<TSensorCT<2>, 0>,
+        TArduinoWired<TSensorCounter<3>, 0>,
+        TLedActor> workflow;
+    TOwner& owner = workflow.Get<0>();
+    workflow.Begin();
+    RunSketch(workflow, owner, &workflow.Get<1>());
+    Host::UseSimulatedClock(false);
+}
+
+
+// actors wired to others of the workflow, the serial port forward to the
+// bluetooth actor listed after it
+void CheckWiredBluetooth() {
+    Host::UseSimulatedClock(true);
+    TArduinoWorkflow<
+        TOwner,
+        TArduinoWired<TSerialActor<THardwareSerial<Serial, 115200>>, 2>,
+        TArduinoWired<TBluetoothActor<TBluetoothHC05<>>, 0, 1>> workflow;
+    TVirtualIdle idle;
+    TOwner& owner = workflow.Get<0>();
+    workflow.SetIdle(&idle);
+    Serial.ClearOutput();
+    workflow.Begin();
+    // powered up, the module gets its AT command
+    unsigned long end = millis() + 2000;
+    while ((long)(end - millis()) > 0) {
+        workflow.Run();
+    }
+    CHECK(Serial.OutputSize == 3);
+    Serial.Feed("OK\r\n", 4);
+    end = millis() + 2000;
+    while ((long)(end - millis()) > 0) {
+        workflow.Run();
+    }
+    CHECK(workflow.Get<2>().IsOK());
+    // once the module is set up, lines go on to the owner
+    Serial.Feed("hello\n", 6);
+    end = millis() + 100;
+    while ((long)(end - millis()) > 0) {
+        workflow.Run();
+    }
+    Host::UseSimulatedClock(false);
+    CHECK(owner.Lines.size() == 1 && owner.Lines[0] == "hello");
+}
+
+}
+
+int main() {
+    CheckStaticString();
+    CheckFormatFloat();
+    CheckTimerOrder();
+    CheckDropLowest();
+    CheckInterruptThread();
+    CheckDiagnosticsCall();
+    CheckCallBatched();
+    CheckEventDelete();
+    CheckSerialLongLines();
+    CheckSerialSleeps();
+    CheckSketch();
+    CheckSketchStatic();
+    CheckWiredBluetooth();
+    printf("all checks passed\n");
+    return 0;
+}